@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   adc.h
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#ifndef STM8_ADC_H
+#define STM8_ADC_H
+
+#include <stdbool.h>
+#include <stm8.h>
+#include <utils.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// ADC1 registers
+///////////////////////////////////////////////////////////////////////////////
+#define REGISTER_ADC_DB0RH REGISTER(0x53E0) // Data buffer register 0 high
+#define REGISTER_ADC_DB0RL REGISTER(0x53E1) // Data buffer register 0 low
+#define REGISTER_ADC_CSR   REGISTER(0x5400) // Control/status register
+#define REGISTER_ADC_CR1   REGISTER(0x5401) // Configuration register 1
+#define REGISTER_ADC_CR2   REGISTER(0x5402) // Configuration register 2
+#define REGISTER_ADC_CR3   REGISTER(0x5403) // Configuration register 3
+#define REGISTER_ADC_DRH   REGISTER(0x5404) // Data register high
+#define REGISTER_ADC_DRL   REGISTER(0x5405) // Data register low
+#define REGISTER_ADC_TDRH  REGISTER(0x5406) // Schmitt trigger disable register high
+#define REGISTER_ADC_TDRL  REGISTER(0x5407) // Schmitt trigger disable register low
+#define REGISTER_ADC_HTRH  REGISTER(0x5408) // High threshold register high
+#define REGISTER_ADC_HTRL  REGISTER(0x5409) // High threshold register low
+#define REGISTER_ADC_LTRH  REGISTER(0x540A) // Low threshold register high
+#define REGISTER_ADC_LTRL  REGISTER(0x540B) // Low threshold register low
+#define REGISTER_ADC_AWSRH REGISTER(0x540C) // Analog watchdog status register high
+#define REGISTER_ADC_AWSRL REGISTER(0x540D) // Analog watchdog status register low
+#define REGISTER_ADC_AWCRH REGISTER(0x540E) // Analog watchdog control register high
+#define REGISTER_ADC_AWCRL REGISTER(0x540F) // Analog watchdog control register low
+
+// The data buffer registers of the channel i (0-9)
+#define _REGISTER_ADC_DBRH(i) REGISTER(0x53E0 + 2 * (i))
+#define _REGISTER_ADC_DBRL(i) REGISTER(0x53E1 + 2 * (i))
+
+///////////////////////////////////////////////////////////////////////////////
+// ADC1 register flags
+///////////////////////////////////////////////////////////////////////////////
+#define ADC_CSR_EOC     (uint8_t) 0b10000000 // End of conversion
+#define ADC_CSR_AWD     (uint8_t) 0b01000000 // Analog watchdog flag
+#define ADC_CSR_EOCIE   (uint8_t) 0b00100000 // Interrupt enable for EOC
+#define ADC_CSR_AWDIE   (uint8_t) 0b00010000 // Analog watchdog interrupt enable
+#define _ADC_CSR_CH_MASK (uint8_t) 0b00001111 // Channel selection
+#define _ADC_CR1_SPSEL_SHIFT 4 // Prescaler selection
+#define ADC_CR1_CONT    (uint8_t) 0b00000010 // Continuous conversion
+#define ADC_CR1_ADON    (uint8_t) 0b00000001 // A/D converter on/off
+#define ADC_CR2_EXTTRIG (uint8_t) 0b01000000 // External trigger enable
+#define ADC_CR2_ALIGN   (uint8_t) 0b00001000 // Data alignment (right)
+#define ADC_CR2_SCAN    (uint8_t) 0b00000010 // Scan mode enable
+#define ADC_CR3_DBUF    (uint8_t) 0b10000000 // Data buffer enable
+#define ADC_CR3_OVR     (uint8_t) 0b01000000 // Overrun flag
+
+// The EOC and AWD flags are cleared by writing 0 and writing 1 has no effect,
+// so the bits of the CSR are changed with these macros, which write the flags
+// as 1. A plain read-modify-write would also clear a flag which sets between
+// the read and the write.
+#define _ADC_CSR_FLAGS (uint8_t)(ADC_CSR_EOC | ADC_CSR_AWD)
+#define _adcCsrSet(bits) REGISTER_ADC_CSR = (uint8_t)(REGISTER_ADC_CSR | _ADC_CSR_FLAGS | (bits))
+#define _adcCsrUnset(bits) REGISTER_ADC_CSR = (uint8_t)((REGISTER_ADC_CSR | _ADC_CSR_FLAGS) & ~(bits))
+
+///////////////////////////////////////////////////////////////////////////////
+// The conversion modes, which can be combined with |
+///////////////////////////////////////////////////////////////////////////////
+#define ADC_SINGLE     (uint8_t) 0b00000000 // One conversion for every adcStart()
+#define ADC_CONTINUOUS (uint8_t) 0b00000001 // The conversions repeat until adcStop()
+#define ADC_SCAN       (uint8_t) 0b00000010 // Convert all the channels from 0 up to the given one
+
+///////////////////////////////////////////////////////////////////////////////
+// The number of channels with a result. Scans can go up to the channel
+// ADC_CHANNELS - 1. The default covers the AIN2-AIN6 of the STM8S103F. It is
+// set in the Makefile.
+///////////////////////////////////////////////////////////////////////////////
+#ifdef ADC_CHANNELS
+#error "ADC_CHANNELS must be set in the Makefile, as the library is compiled with it"
+#endif
+#ifdef _STM8_ADC_CHANNELS
+#define ADC_CHANNELS _STM8_ADC_CHANNELS
+#else
+#define ADC_CHANNELS 7
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper values for computing the prescaler. The fADC is f_master divided by
+// 2, 3, 4, 6, 8, 10, 12 or 18 and we select the smallest divider which keeps
+// it up to 4 MHz (the maximum for the whole supply range). The f_master is
+// given in MHz.
+///////////////////////////////////////////////////////////////////////////////
+#define _ADC_SPSEL(frequency) (\
+  (frequency) <= 8 ? 0 :\
+  (frequency) <= 12 ? 1 :\
+  (frequency) <= 16 ? 2 :\
+  (frequency) <= 24 ? 3 : 4)
+
+// The state of the ADC driver
+typedef struct {
+  void (*on_results)(void); // The user function called for new results (or 0)
+  void (*on_watchdog)(uint16_t); // The user function called with the channels out of the window (or 0)
+  uint8_t slots; // The number of channels converted in every round
+  uint8_t samples; // The number of results in the data buffer at every EOC
+  bool buffered; // If the results are read from the data buffer
+  uint8_t oversampling; // The number of extra bits of the results
+  uint8_t rounds; // The number of rounds accumulated so far
+  uint16_t sum[ADC_CHANNELS]; // The accumulated samples of every channel
+  volatile uint16_t result[ADC_CHANNELS]; // The latest results
+  volatile uint8_t sequence; // Incremented every time new results are stored
+  volatile uint8_t overruns; // The number of data buffer overruns
+} _AdcState;
+
+// The ADC state, which is defined by the adcInterruptHandler() macro
+extern _AdcState _adc_state;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Macros and methods for handling the ADC, to be used by the user
+///////////////////////////////////////////////////////////////////////////////
+
+// Initializes the ADC. Use the adcInitialize() macro instead, which computes
+// the prescaler.
+void _adcInitialize(_AdcState* state, uint8_t spsel, uint8_t channel,
+                    uint8_t mode, uint8_t oversampling);
+
+// Initializes the ADC, which delivers its results with interrupts (see the
+// adcInterruptHandler()). The parameters must be constants. Results are 10-bit
+// (right aligned) plus the oversampling bits, which are gained by summing 4^n
+// samples of every channel and dividing by 2^n (so the noise must be at least
+// one LSB for the extra bits to be meaningful). With oversampling the results
+// are updated every 4^n samples of each channel.
+// Parameters:
+// - frequency: The frequency f_master (in MHz)
+// - channel: The channel to convert, or the last one in scan mode
+// - mode: ADC_SINGLE, or a combination of ADC_CONTINUOUS and ADC_SCAN
+// - oversampling: The number of extra bits of the results (0-3)
+#define adcInitialize(frequency, channel, mode, oversampling) do {\
+  _Static_assert((channel) < ADC_CHANNELS, "The channel has no result in ADC_CHANNELS");\
+  _Static_assert((oversampling) <= 3, "Up to 3 bits of oversampling are supported");\
+  _adcInitialize(&_adc_state, _ADC_SPSEL(frequency), channel, mode, oversampling);\
+} while(0)
+
+// Starts the conversions. In single mode it must be called for every
+// conversion (or scan), while the continuous conversions go on until the
+// adcStop().
+#define adcStart() registerSet(REGISTER_ADC_CR1, ADC_CR1_ADON)
+
+// Stops the conversions and powers down the ADC. The adcInitialize() must be
+// called again before the next adcStart().
+#define adcStop() REGISTER_ADC_CR1 &= ~ADC_CR1_ADON
+
+// Enables the analog watchdog for the given channels. When a conversion of
+// these channels is out of the window the watchdog function of the
+// adcInterruptHandler() is called, without waiting for the end of the round.
+// Parameters:
+// - channels: A mask with the bit of every channel to watch
+// - low: The low threshold (10-bit)
+// - high: The high threshold (10-bit)
+void adcEnableWatchdog(uint16_t channels, uint16_t low, uint16_t high);
+
+// Disables the analog watchdog
+#define adcDisableWatchdog() _adcCsrUnset(ADC_CSR_AWDIE)
+
+// Returns the latest result of a channel. In scan mode the channel is the
+// index in the scan, otherwise it must be 0. The read is done with the
+// interrupts disabled, so the two bytes belong to the same result.
+uint16_t _adcRead(_AdcState* state, uint8_t channel);
+#define adcRead(channel) _adcRead(&_adc_state, channel)
+
+// Returns a counter which is incremented every time new results are stored,
+// so the main loop can detect them without a callback
+#define adcSequence() (_adc_state.sequence)
+
+// Reads the results of a round from the data register or the data buffer and
+// accumulates them. In right alignment the low byte must be read first.
+// Returns true if new results were stored.
+bool _adcConversionDone(_AdcState* state);
+
+// Handles the ADC interrupt
+void _adc(_AdcState* state);
+
+//
+// This macro implements the ADC interrupt handler. There is a single end of
+// conversion interrupt for every round: a single conversion, a scan of all the
+// channels or ten continuous conversions of one channel (which all go to the
+// same result). The results can be read with the adcRead() at any time.
+//
+// Parameters:
+// - onResults: A function without parameters, which is called from the
+//              interrupt when new results are stored, or 0
+// - onWatchdog: A function with a uint16_t parameter, which is called from the
+//               interrupt with the mask of the channels which are out of the
+//               watchdog window, or 0
+//
+// For an example of how to use this macro see the src/examples/adc_example.c
+//
+#define adcInterruptHandler(onResults, onWatchdog) \
+_AdcState _adc_state = { onResults, onWatchdog };\
+void _adcInterruptHandler() __interrupt(ITC_IRQ_ADC1) {\
+  _adc(&_adc_state);\
+}
+
+#endif /* STM8_ADC_H */
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   awu.h
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#ifndef STM8_AWU_H
+#define STM8_AWU_H
+
+#include <stm8.h>
+#include <utils.h>
+#include <clk.h>
+#include <itc.h>
+#include <tim1.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// AWU registers
+///////////////////////////////////////////////////////////////////////////////
+#define REGISTER_AWU_CSR REGISTER(0x50F0) // Control/status register
+#define REGISTER_AWU_APR REGISTER(0x50F1) // Asynchronous prescaler register
+#define REGISTER_AWU_TBR REGISTER(0x50F2) // Timebase selection register
+
+// The flash control register, which controls the flash power in active-halt
+#define REGISTER_FLASH_CR1 REGISTER(0x505A)
+
+///////////////////////////////////////////////////////////////////////////////
+// AWU register flags
+///////////////////////////////////////////////////////////////////////////////
+#define AWU_CSR_AWUF  (uint8_t) 0b00100000 // Auto-wakeup flag
+#define AWU_CSR_AWUEN (uint8_t) 0b00010000 // Auto-wakeup enable
+#define AWU_CSR_MSR   (uint8_t) 0b00000001 // LSI measurement enable
+#define _FLASH_CR1_AHALT (uint8_t) 0b00001000 // Flash powered down in active-halt
+
+// The nominal frequency of the LSI (in Hz), which can be off by up to 12%
+// between devices and temperatures
+#define AWU_LSI_FREQUENCY 128000UL
+
+// The number of LSI periods measured by the awuMeasureLsi() (in groups of 8)
+#define _AWU_MEASURE_GROUPS 16
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Macros and methods for using the AWU, to be used by the user
+///////////////////////////////////////////////////////////////////////////////
+
+// Measures the frequency of the LSI against the f_master, using the TIM1 input
+// capture 1, which is internally connected to the LSI. It busy-waits for 128
+// LSI periods (about 1 ms) and leaves the TIM1 in its reset state. If the LSI
+// does not run it gives up after two TIM1 overflows without a capture (about
+// 8 ms at 16 MHz). The result
+// is as accurate as the f_master, so it is better measured while running from
+// the HSE or a trimmed HSI. The TIM1 and the AWU must be clocked (see the
+// clkEnablePeripherals()).
+// Parameters:
+// - frequency: The frequency f_master (in MHz)
+// Returns:
+//    The frequency of the LSI (in Hz), or 0 if the LSI does not run
+uint32_t awuMeasureLsi(uint8_t frequency);
+
+// Enables the auto-wakeup with the given interval, which is the time the MCU
+// stays in active-halt after every halt(). The interval is realized as
+// M * APRDIV LSI periods, where M is selected by the timebase (powers of two up
+// to 4096, 10240 or 61440) and APRDIV (2-64) by the prescaler. The smallest
+// timebase which fits the interval is used, so the error is below 1% plus the
+// error of the LSI frequency. It also configures the active-halt for the lowest
+// consumption, with the main regulator and the flash powered down, which
+// makes the wakeup a few tens of microseconds slower.
+// Parameters:
+// - lsi: The frequency of the LSI (in Hz), as returned by the awuMeasureLsi(),
+//        or the AWU_LSI_FREQUENCY if no calibration is needed
+// - interval: The wakeup interval (in ms), from 1 ms up to 30 s
+void awuInitialize(uint32_t lsi, uint16_t interval);
+
+// Disables the auto-wakeup, so the halt() stops the MCU until an external
+// interrupt
+#define awuDisable() do {\
+  REGISTER_AWU_CSR &= ~AWU_CSR_AWUEN;\
+  REGISTER_AWU_TBR = 0;\
+} while(0)
+
+// Handles the AWU interrupt
+void _awuWakeup(void (*on_wakeup)(void));
+
+//
+// This macro implements the AWU interrupt handler, which is executed every
+// time the MCU wakes up from the active-halt. It must be used when the AWU is
+// enabled, even without a function, because it clears the wakeup flag.
+// Parameters:
+// - onWakeup: A function without parameters, which is called from the
+//             interrupt, or 0
+//
+// For an example of how to use this macro see the src/examples/awu_example.c
+//
+#define awuInterruptHandler(onWakeup) \
+void _awuInterruptHandler() __interrupt(ITC_IRQ_AWU) {\
+  _awuWakeup(onWakeup);\
+}
+
+#endif /* STM8_AWU_H */
@@ -27,23 +27,24 @@
 
 #include <stm8.h>
 #include <gpio.h>
+#include <itc.h>
 #include <utils.h>
 
 ///////////////////////////////////////////////////////////////////////////////
 // Clock related registers
 ///////////////////////////////////////////////////////////////////////////////
-#define REGISTER_CLK_ICKR REGISTER     0x50C0 // Internal clock control register
-#define REGISTER_CLK_ECKR REGISTER     0x50C1 // External clock control register
-#define REGISTER_CLK_CMSR REGISTER     0x50C3 // Clock master status register
-#define REGISTER_CLK_SWR REGISTER      0x50C4 // Clock master switch register
-#define REGISTER_CLK_SWCR REGISTER     0x50C5 // Clock switch control register
-#define REGISTER_CLK_CKDIVR REGISTER   0x50C6 // Clock divider register
-#define REGISTER_CLK_PCKENR1 REGISTER  0x50C7 // Peripheral clock gaing register 1
-#define REGISTER_CLK_CSSR REGISTER     0x50C8 // Clock security system register
-#define REGISTER_CLK_CCOR REGISTER     0x50C9 // Configurable clock control register
-#define REGISTER_CLK_PCKENR2 REGISTER  0x50CA // Periphera clock gating register 2
-#define REGISTER_CLK_HSITRIMR REGISTER 0x50CC // HSI clock calibration trimming register
-#define REGISTER_CLK_SWIMCCR REGISTER  0x50CD // SWIM clock control register
+#define REGISTER_CLK_ICKR REGISTER(0x50C0)     // Internal clock control register
+#define REGISTER_CLK_ECKR REGISTER(0x50C1)     // External clock control register
+#define REGISTER_CLK_CMSR REGISTER(0x50C3)     // Clock master status register
+#define REGISTER_CLK_SWR REGISTER(0x50C4)      // Clock master switch register
+#define REGISTER_CLK_SWCR REGISTER(0x50C5)     // Clock switch control register
+#define REGISTER_CLK_CKDIVR REGISTER(0x50C6)   // Clock divider register
+#define REGISTER_CLK_PCKENR1 REGISTER(0x50C7)  // Peripheral clock gaing register 1
+#define REGISTER_CLK_CSSR REGISTER(0x50C8)     // Clock security system register
+#define REGISTER_CLK_CCOR REGISTER(0x50C9)     // Configurable clock control register
+#define REGISTER_CLK_PCKENR2 REGISTER(0x50CA)  // Periphera clock gating register 2
+#define REGISTER_CLK_HSITRIMR REGISTER(0x50CC) // HSI clock calibration trimming register
+#define REGISTER_CLK_SWIMCCR REGISTER(0x50CD)  // SWIM clock control register
 
 ///////////////////////////////////////////////////////////////////////////////
 // Helper values for setting the HSI divider
@@ -96,6 +97,38 @@
 #define _CLK_CCOR_CCOBSY (uint8_t)0b01000000
 #define _CLK_CCOR_CCORDY (uint8_t)0b00100000
 #define _CLK_CCOR_CCOEN  (uint8_t)0b00000001
+#define _CLK_ICKR_REGAH  (uint8_t)0b00100000
+#define _CLK_ICKR_FHWU   (uint8_t)0b00000100
+#define _CLK_SWCR_SWIF   (uint8_t)0b00001000
+#define _CLK_SWCR_SWIEN  (uint8_t)0b00000100
+#define _CLK_SWCR_SWEN   (uint8_t)0b00000010
+#define _CLK_SWCR_SWBSY  (uint8_t)0b00000001
+#define _CLK_CSSR_CSSD   (uint8_t)0b00001000
+#define _CLK_CSSR_CSSDIE (uint8_t)0b00000100
+#define _CLK_CSSR_AUX    (uint8_t)0b00000010
+#define _CLK_CSSR_CSSEN  (uint8_t)0b00000001
+
+///////////////////////////////////////////////////////////////////////////////
+// The master clock sources, as written in the CLK_SWR and read from the
+// CLK_CMSR
+///////////////////////////////////////////////////////////////////////////////
+#define _CLK_SOURCE_HSI (uint8_t)0xE1
+#define _CLK_SOURCE_LSI (uint8_t)0xD2
+#define _CLK_SOURCE_HSE (uint8_t)0xB4
+
+///////////////////////////////////////////////////////////////////////////////
+// The peripherals with a clock gate, which can be combined with |. The low
+// byte is the PCKENR1 and the high byte the PCKENR2. The UART1 bit is not the
+// same in all the STM8S devices (PCKEN13 in the STM8S103), so both are used.
+///////////////////////////////////////////////////////////////////////////////
+#define CLK_PERIPHERAL_I2C   (uint16_t)0x0001
+#define CLK_PERIPHERAL_SPI   (uint16_t)0x0002
+#define CLK_PERIPHERAL_UART1 (uint16_t)0x000C
+#define CLK_PERIPHERAL_TIM4  (uint16_t)0x0010
+#define CLK_PERIPHERAL_TIM2  (uint16_t)0x0020
+#define CLK_PERIPHERAL_TIM1  (uint16_t)0x0080
+#define CLK_PERIPHERAL_AWU   (uint16_t)0x0400
+#define CLK_PERIPHERAL_ADC   (uint16_t)0x0800
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -139,5 +172,133 @@
 // Disable the clock output
 #define clkDisableCco() registerUnset(REGISTER_CLK_CCOR, _CLK_CCOR_CCOEN)
 
+// Enables the clock of peripherals. After reset all the peripherals are
+// clocked. The registers of a peripheral cannot be accessed while its clock is
+// disabled.
+// Parameters:
+// - peripherals: A combination of CLK_PERIPHERAL_***
+#define clkEnablePeripherals(peripherals) do {\
+  REGISTER_CLK_PCKENR1 |= (uint8_t)(peripherals);\
+  REGISTER_CLK_PCKENR2 |= (uint8_t)((peripherals) >> 8);\
+} while(0)
+
+// Disables the clock of peripherals, to reduce the consumption. The
+// peripherals keep their configuration, but they are stopped.
+// Parameters:
+// - peripherals: A combination of CLK_PERIPHERAL_***
+#define clkDisablePeripherals(peripherals) do {\
+  REGISTER_CLK_PCKENR1 &= (uint8_t)~(peripherals);\
+  REGISTER_CLK_PCKENR2 &= (uint8_t)~((peripherals) >> 8);\
+} while(0)
+
+// Enables the clock of the given peripherals and disables all the others. It
+// is meant to be called at the beginning of every program, before the
+// peripherals are initialized, together with the
+// gpioSetAllPortsInputPullUpNoInt(), to use the minimum power.
+// Parameters:
+// - peripherals: A combination of CLK_PERIPHERAL_***
+#define clkEnableOnlyPeripherals(peripherals) do {\
+  REGISTER_CLK_PCKENR1 = (uint8_t)(peripherals);\
+  REGISTER_CLK_PCKENR2 = (uint8_t)((peripherals) >> 8);\
+} while(0)
+
+// Checks if the given source is the current master clock
+// Parameters:
+// - source: One of HSI, HSE or LSI
+#define _clkIsSource(source) (REGISTER_CLK_CMSR == _CLK_SOURCE_##source)
+#define clkIsSource(source) _clkIsSource(source)
+
+// Starts the automatic switch of the master clock. The target oscillator is
+// started and the switch happens by the hardware as soon as it is stable, so
+// the method returns immediately. The end of the switch can be detected with
+// the clkIsSwitching() or with the switch interrupt (see the
+// clkEnableSwitchInterrupt()). Note that the LSI can be used as master clock
+// only if it is enabled by the LSI_EN option byte, and that the HSE needs a
+// crystal or clock on the A1 and A2 pins. The HSI divider does not affect the
+// other sources.
+// Parameters:
+// - source: One of HSI, HSE or LSI
+#define _clkStartSwitch(source) do {\
+  REGISTER_CLK_SWCR &= ~_CLK_SWCR_SWIF;\
+  registerSet(REGISTER_CLK_SWCR, _CLK_SWCR_SWEN);\
+  REGISTER_CLK_SWR = _CLK_SOURCE_##source;\
+} while(0)
+#define clkStartSwitch(source) _clkStartSwitch(source)
+
+// Starts the manual switch of the master clock. The target oscillator is
+// started, but the switch happens only when the clkCompleteSwitch() is called,
+// which must be after the clkSwitchReady() (or the switch interrupt) reports
+// that the oscillator is stable. Meanwhile the code keeps running from the
+// current clock, so it can prepare the peripherals for the new frequency.
+// Parameters:
+// - source: One of HSI, HSE or LSI
+#define _clkPrepareSwitch(source) do {\
+  REGISTER_CLK_SWCR &= ~(_CLK_SWCR_SWIF | _CLK_SWCR_SWEN);\
+  REGISTER_CLK_SWR = _CLK_SOURCE_##source;\
+} while(0)
+#define clkPrepareSwitch(source) _clkPrepareSwitch(source)
+
+// Returns true when the target oscillator of a manual switch is stable
+#define clkSwitchReady() (REGISTER_CLK_SWCR & _CLK_SWCR_SWIF)
+
+// Completes a manual switch
+#define clkCompleteSwitch() registerSet(REGISTER_CLK_SWCR, _CLK_SWCR_SWEN)
+
+// Returns true while a switch is in progress
+#define clkIsSwitching() (REGISTER_CLK_SWCR & _CLK_SWCR_SWBSY)
+
+// Aborts a switch in progress (for example when the HSE does not start), so
+// the master clock stays the current one
+#define clkAbortSwitch() REGISTER_CLK_SWCR &= ~_CLK_SWCR_SWBSY
+
+// Enables the switch interrupt, which is triggered when an automatic switch is
+// finished, or when the target oscillator of a manual switch is stable. The
+// clkInterruptHandler() must be used.
+#define clkEnableSwitchInterrupt() registerSet(REGISTER_CLK_SWCR, _CLK_SWCR_SWIEN)
+
+// Disables the switch interrupt
+#define clkDisableSwitchInterrupt() REGISTER_CLK_SWCR &= ~_CLK_SWCR_SWIEN
+
+// Enables the clock security system, which monitors the HSE. If the HSE fails,
+// the master clock is switched to the HSI divided by 8 and the CSS interrupt
+// is triggered (the clkInterruptHandler() must be used). The CSS cannot be
+// disabled until the next reset.
+#define clkEnableCss() REGISTER_CLK_CSSR = _CLK_CSSR_CSSEN | _CLK_CSSR_CSSDIE
+
+// Returns true if the CSS detected a failure of the HSE
+#define clkCssDetected() (REGISTER_CLK_CSSR & _CLK_CSSR_CSSD)
+
+//
+// This macro implements the clock controller interrupt handler, which handles
+// the switch and the clock security system interrupts.
+// Parameters:
+// - onSwitch: A function without parameters, which is called when a switch
+//             interrupt occurs, or 0
+// - onFailure: A function without parameters, which is called when the CSS
+//              detects a failure of the HSE, or 0. The master clock is the
+//              HSI divided by 8 at this point, so it could for example restore
+//              the HSI divider.
+//
+// For an example of how to use this macro see the
+// src/programs/WheelSpeedReader.c
+//
+#define clkInterruptHandler(onSwitch, onFailure) \
+void _clkInterruptHandler() __interrupt(ITC_IRQ_CLK) {\
+  void (*on_switch)(void) = onSwitch;\
+  void (*on_failure)(void) = onFailure;\
+  if (REGISTER_CLK_SWCR & _CLK_SWCR_SWIF) {\
+    REGISTER_CLK_SWCR &= ~_CLK_SWCR_SWIF;\
+    if (on_switch) {\
+      (*on_switch)();\
+    }\
+  }\
+  if (REGISTER_CLK_CSSR & _CLK_CSSR_CSSD) {\
+    REGISTER_CLK_CSSR &= ~_CLK_CSSR_CSSD;\
+    if (on_failure) {\
+      (*on_failure)();\
+    }\
+  }\
+}
+
 #endif /* STM8_CLK_H */
 
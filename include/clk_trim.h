@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   clk_trim.h
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#ifndef STM8_CLK_TRIM_H
+#define STM8_CLK_TRIM_H
+
+#include <stdbool.h>
+#include <stm8.h>
+#include <clk.h>
+#include <tim1.h>
+
+// The range of the HSI trimming value, which is a 4 bit signed number. Bigger
+// values make the HSI faster.
+#define CLK_HSI_TRIM_MIN -8
+#define CLK_HSI_TRIM_MAX 7
+
+// The option byte OPT2, whose AFR0 bit remaps the C7 to the TIM1_CH2 (and the
+// C5, C6 to the TIM2_CH1, TIM1_CH1) instead of the SPI. It can only be changed
+// by programming the option bytes (for example with the stm8flash). Note that
+// the TIM2_CH1 then moves from the D4 to the C5, so the TIM2 capture 1 sees the
+// C5 and the SPI cannot be used.
+#define _REGISTER_OPT2 REGISTER_RO(0x4803)
+#define _OPT2_AFR0 (uint8_t) 0b00000001
+
+// The TIM1 overflows without a reference edge after which the measurement of
+// the clkMeasureTim1Reference() gives up
+#define _CLK_TRIM_TIMEOUT 3
+
+// The result of the HSI calibration
+typedef struct {
+  int8_t trim; // The selected trimming value
+  int32_t error_ppm; // The remaining error of the f_master (in ppm, positive if fast)
+} HsiTrimResult;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Macros and methods for trimming the HSI, to be used by the user
+///////////////////////////////////////////////////////////////////////////////
+
+// Sets the HSI trimming value
+// Parameters:
+// - trim: The trimming value, from CLK_HSI_TRIM_MIN to CLK_HSI_TRIM_MAX
+#define clkSetHsiTrim(trim) REGISTER_CLK_HSITRIMR = (uint8_t)(trim) & 0x0F
+
+// Returns the current HSI trimming value (as an int8_t)
+#define clkGetHsiTrim() (int8_t)(\
+  (REGISTER_CLK_HSITRIMR & 0x08) ? (REGISTER_CLK_HSITRIMR & 0x0F) - 16 : (REGISTER_CLK_HSITRIMR & 0x0F))
+
+// Returns true if the option byte AFR0 is set, so the pin C7 is the TIM1_CH2
+// input and can be used for the reference of the clkStartTim1Reference()
+#define clkTim1ReferenceAvailable() (bool)(_REGISTER_OPT2 & _OPT2_AFR0)
+
+// Starts the TIM1 as a free running counter, capturing the rising edges of
+// the reference signal on the capture 2 (pin C7). On the STM8S103F the C7 is
+// the TIM1_CH2 only when the AFR0 option bit is set (see the
+// clkTim1ReferenceAvailable()), otherwise no edge is captured. The TIM1 must be
+// clocked (see the clkEnablePeripherals()).
+// Parameters:
+// - prescaler: The TIM1 prescaler (1-65536). It must be selected so that a
+//              period of the reference is less than 65536 TIM1 ticks, for
+//              example 256 for a 1 Hz reference at 16 MHz.
+void clkStartTim1Reference(uint32_t prescaler);
+
+// Returns the TIM1 to its reset state, after the clkStartTim1Reference()
+void clkStopTim1Reference();
+
+// Measures a period of the reference signal started by the
+// clkStartTim1Reference(). It busy-waits for two rising edges, so it takes up
+// to two periods of the reference.
+// Returns:
+//    The TIM1 ticks between the two edges, or 0 if there is no reference
+uint32_t clkMeasureTim1Reference();
+
+// Returns the error of a measurement (in ppm). To avoid overflows the ppm are
+// computed as 15625 * difference / (expected / 64), which adds an error of
+// less than 64 / expected of the result.
+int32_t _clkTrimError(uint32_t measured, uint32_t expected);
+
+// Trims the HSI so that the measurement of a reference signal is as close as
+// possible to its expected value. Starting from the current trimming value,
+// it steps towards the expected value until the error stops decreasing or
+// changes sign, so it needs only a few measurements when the HSI is close to
+// its nominal frequency. The HSI changes with the temperature, so the
+// calibration should be repeated when the temperature changes. Any timings
+// which depend on the f_master (timers, I2C, etc) are affected by the trimming.
+// Parameters:
+// - measure: The method which measures the reference, in f_master derived
+//            ticks (for example the clkMeasureTim1Reference()). It must return
+//            0 if there is no reference, which aborts the calibration. The
+//            difference from the expected value must be less than 137000.
+// - expected: The ticks the measure method returns with the nominal f_master
+// - result: Where the selected trim and the remaining error are stored
+// Returns:
+//    true if the calibration was done, false if there was no reference (the
+//    initial trimming value is kept)
+bool clkCalibrateHsi(uint32_t (*measure)(void), uint32_t expected, HsiTrimResult* result);
+
+#endif /* STM8_CLK_TRIM_H */
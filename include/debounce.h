@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   debounce.h
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#ifndef STM8_DEBOUNCE_H
+#define STM8_DEBOUNCE_H
+
+#include <stdbool.h>
+#include <stm8.h>
+#include <gpio.h>
+#include <timer.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Debouncing of whole GPIO ports, sampled by a software timer (see timer.h).
+// A pin changes its debounced state only after it is read with the new level
+// for a number of consecutive samples, so bounces and glitches shorter than
+// that are ignored. All the 8 pins of a port are filtered at once with
+// vertical counters: the bit n of the count0, count1 and count2 form the 3-bit
+// counter of the pin n, so every sample costs a few byte operations no matter
+// how many pins bounce.
+///////////////////////////////////////////////////////////////////////////////
+
+// The maximum number of consecutive samples a change must last
+#define DEBOUNCE_MAX_SAMPLES 8
+
+// The debouncer of a GPIO port. Its members are managed by the debounce methods.
+typedef struct {
+  Timer timer; // The timer which samples the port
+  const volatile uint8_t* input; // The IDR register of the port
+  uint8_t state; // The debounced state of the pins
+  uint8_t count0; // The bit 0 of the counters of the pins
+  uint8_t count1; // The bit 1 of the counters of the pins
+  uint8_t count2; // The bit 2 of the counters of the pins
+  uint8_t limit0; // 0xFF if the bit 0 of (samples - 1) is set, 0 otherwise
+  uint8_t limit1; // 0xFF if the bit 1 of (samples - 1) is set, 0 otherwise
+  uint8_t limit2; // 0xFF if the bit 2 of (samples - 1) is set, 0 otherwise
+  void (*on_edges)(uint8_t, uint8_t); // Called with the debounced rising and falling pins
+} Debouncer;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal methods, not to be used by the user
+///////////////////////////////////////////////////////////////////////////////
+
+// Takes the current state of the port as debounced and sets up the counters
+// for the given number of samples
+void _debounceInitialize(Debouncer* debouncer, const volatile uint8_t* input,
+                         uint8_t samples, void (*on_edges)(uint8_t, uint8_t));
+
+// Reads the port and updates the counters. Called by the timer of the
+// debouncer, with the debouncer as the context.
+void _debounceSample(void* context);
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Macros for debouncing the GPIO ports, to be used by the user
+///////////////////////////////////////////////////////////////////////////////
+
+// Starts debouncing a GPIO port. The current levels of the pins are taken as
+// their debounced state. The software timers must be initialized and their
+// interrupt handler defined (see timer.h).
+// Parameters:
+// - debouncer: A pointer to the Debouncer
+// - port: The port name as an uppercase letter
+// - samples: The number of consecutive samples a change must last (1-8)
+// - period: The ms between the samples
+// - onEdges: A method with two uint8_t parameters, the masks of the pins which
+//            went high and low, or 0. It is called from the TIM4 interrupt,
+//            only for samples with debounced edges.
+#define _debounceStart(debouncer, port, samples, period, onEdges) do {\
+  _Static_assert((samples) >= 1 && (samples) <= DEBOUNCE_MAX_SAMPLES, "The samples must be 1-8");\
+  _debounceInitialize(debouncer, &REGISTER_P##port##_IDR, samples, onEdges);\
+  timerSetup(&(debouncer)->timer, _debounceSample, debouncer);\
+  timerStart(&(debouncer)->timer, period, period);\
+} while(0)
+#define debounceStart(debouncer, port, samples, period, onEdges) _debounceStart(debouncer, port, samples, period, onEdges)
+
+// Stops sampling the port. The debounced state keeps its last value.
+// Parameters:
+// - debouncer: A pointer to the Debouncer
+#define debounceStop(debouncer) timerStop(&(debouncer)->timer)
+
+// Returns the debounced state of all the pins of the port, as a uint8_t with
+// one bit per pin
+#define debounceRead(debouncer) ((debouncer)->state)
+
+// Returns the debounced state of a pin as a bool
+// Parameters:
+// - debouncer: A pointer to the Debouncer
+// - pin: The pin of the port, a number in range [0,7]
+#define debounceReadPin(debouncer, pin) (bool)((debouncer)->state & gpioPinMask(pin))
+
+#endif /* STM8_DEBOUNCE_H */
@@ -44,36 +44,50 @@
 ///////////////////////////////////////////////////////////////////////////////
 // GPIO registers
 ///////////////////////////////////////////////////////////////////////////////
-#define REGISTER_PA_ODR REGISTER    0x5000
-#define REGISTER_PA_IDR REGISTER_RO 0x5001
-#define REGISTER_PA_DDR REGISTER    0x5002
-#define REGISTER_PA_CR1 REGISTER    0x5003
-#define REGISTER_PA_CR2 REGISTER    0x5004
-#define REGISTER_PB_ODR REGISTER    0x5005
-#define REGISTER_PB_IDR REGISTER_RO 0x5006
-#define REGISTER_PB_DDR REGISTER    0x5007
-#define REGISTER_PB_CR1 REGISTER    0x5008
-#define REGISTER_PB_CR2 REGISTER    0x5009
-#define REGISTER_PC_ODR REGISTER    0x500A
-#define REGISTER_PC_IDR REGISTER_RO 0x500B
-#define REGISTER_PC_DDR REGISTER    0x500C
-#define REGISTER_PC_CR1 REGISTER    0x500D
-#define REGISTER_PC_CR2 REGISTER    0x500E
-#define REGISTER_PD_ODR REGISTER    0x500F
-#define REGISTER_PD_IDR REGISTER_RO 0x5010
-#define REGISTER_PD_DDR REGISTER    0x5011
-#define REGISTER_PD_CR1 REGISTER    0x5012
-#define REGISTER_PD_CR2 REGISTER    0x5013
-#define REGISTER_PE_ODR REGISTER    0x5014
-#define REGISTER_PE_IDR REGISTER_RO 0x5015
-#define REGISTER_PE_DDR REGISTER    0x5016
-#define REGISTER_PE_CR1 REGISTER    0x5017
-#define REGISTER_PE_CR2 REGISTER    0x5018
-#define REGISTER_PF_ODR REGISTER    0x5019
-#define REGISTER_PF_IDR REGISTER_RO 0x501A
-#define REGISTER_PF_DDR REGISTER    0x501B
-#define REGISTER_PF_CR1 REGISTER    0x501C
-#define REGISTER_PF_CR2 REGISTER    0x501D
+#define REGISTER_PA_ODR REGISTER(0x5000)
+#define REGISTER_PA_IDR REGISTER_RO(0x5001)
+#define REGISTER_PA_DDR REGISTER(0x5002)
+#define REGISTER_PA_CR1 REGISTER(0x5003)
+#define REGISTER_PA_CR2 REGISTER(0x5004)
+#define REGISTER_PB_ODR REGISTER(0x5005)
+#define REGISTER_PB_IDR REGISTER_RO(0x5006)
+#define REGISTER_PB_DDR REGISTER(0x5007)
+#define REGISTER_PB_CR1 REGISTER(0x5008)
+#define REGISTER_PB_CR2 REGISTER(0x5009)
+#define REGISTER_PC_ODR REGISTER(0x500A)
+#define REGISTER_PC_IDR REGISTER_RO(0x500B)
+#define REGISTER_PC_DDR REGISTER(0x500C)
+#define REGISTER_PC_CR1 REGISTER(0x500D)
+#define REGISTER_PC_CR2 REGISTER(0x500E)
+#define REGISTER_PD_ODR REGISTER(0x500F)
+#define REGISTER_PD_IDR REGISTER_RO(0x5010)
+#define REGISTER_PD_DDR REGISTER(0x5011)
+#define REGISTER_PD_CR1 REGISTER(0x5012)
+#define REGISTER_PD_CR2 REGISTER(0x5013)
+#define REGISTER_PE_ODR REGISTER(0x5014)
+#define REGISTER_PE_IDR REGISTER_RO(0x5015)
+#define REGISTER_PE_DDR REGISTER(0x5016)
+#define REGISTER_PE_CR1 REGISTER(0x5017)
+#define REGISTER_PE_CR2 REGISTER(0x5018)
+#define REGISTER_PF_ODR REGISTER(0x5019)
+#define REGISTER_PF_IDR REGISTER_RO(0x501A)
+#define REGISTER_PF_DDR REGISTER(0x501B)
+#define REGISTER_PF_CR1 REGISTER(0x501C)
+#define REGISTER_PF_CR2 REGISTER(0x501D)
+
+///////////////////////////////////////////////////////////////////////////////
+// GPIO port addresses and register offsets, for the bit instructions
+///////////////////////////////////////////////////////////////////////////////
+#define _GPIO_PA 0x5000
+#define _GPIO_PB 0x5005
+#define _GPIO_PC 0x500A
+#define _GPIO_PD 0x500F
+#define _GPIO_PE 0x5014
+#define _GPIO_PF 0x5019
+#define _GPIO_ODR 0
+#define _GPIO_DDR 2
+#define _GPIO_CR1 3
+#define _GPIO_CR2 4
 
 ///////////////////////////////////////////////////////////////////////////////
 // Default register values
@@ -84,6 +98,27 @@
 #define GPIO_CR2_DEFAULT (uint8_t) 0x00
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Single bit operations on the port registers, which are always compiled to
+// one bset, bres or bcpl instruction. They are atomic, so they never lose
+// changes made by an interrupt to other pins of the same port. The parameters
+// must be literals (or macros of literals), as they are part of the assembly.
+// On the host (see stm8_host.h) they are plain C operations.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef STM8_HOST
+#define __gpioBitInstruction(instruction, port, offset, pin) do {\
+  __asm__(#instruction " " #port "+" #offset ", #" #pin "\n");\
+} while(0)
+#define _gpioBitSet(port, offset, pin) __gpioBitInstruction(bset, port, offset, pin)
+#define _gpioBitReset(port, offset, pin) __gpioBitInstruction(bres, port, offset, pin)
+#define _gpioBitComplement(port, offset, pin) __gpioBitInstruction(bcpl, port, offset, pin)
+#else
+#define _gpioBitSet(port, offset, pin) REGISTER((port) + (offset)) |= (uint8_t)(1 << (pin))
+#define _gpioBitReset(port, offset, pin) REGISTER((port) + (offset)) &= (uint8_t)~(1 << (pin))
+#define _gpioBitComplement(port, offset, pin) REGISTER((port) + (offset)) ^= (uint8_t)(1 << (pin))
+#endif
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // Macros for handling the GPIOs by the user
 ///////////////////////////////////////////////////////////////////////////////
@@ -103,63 +138,63 @@
 // Parameters:
 //    port - The port name as an uppercase letter
 //    pin - The pin of the port to set as input, a number in range [0,7]
-#define _gpioSetAsInput(port, pin) registerUnset(REGISTER_P##port##_DDR, GPIO_PIN_##pin)
+#define _gpioSetAsInput(port, pin) _gpioBitReset(_GPIO_P##port, _GPIO_DDR, pin)
 #define gpioSetAsInput(port, pin) _gpioSetAsInput(port, pin)
 
 // Sets a given GPIO pin as an output by setting the corresponding DDR bit to 1.
 // Parameters:
 //    port - The port name as an uppercase letter
 //    pin - The pin of the port to set as output, a number in range [0,7]
-#define _gpioSetAsOutput(port, pin) registerSet(REGISTER_P##port##_DDR, GPIO_PIN_##pin)
+#define _gpioSetAsOutput(port, pin) _gpioBitSet(_GPIO_P##port, _GPIO_DDR, pin)
 #define gpioSetAsOutput(port, pin) _gpioSetAsOutput(port, pin)
 
 // Sets an input GPIO pin as floating by setting the corresponding CR1 bit to 0.
 // Parameters:
 //    port - The port name as an uppercase letter
 //    pin - The pin of the port to set as floating, a number in range [0,7]
-#define _gpioSetAsFloating(port, pin) registerUnset(REGISTER_P##port##_CR1, GPIO_PIN_##pin)
+#define _gpioSetAsFloating(port, pin) _gpioBitReset(_GPIO_P##port, _GPIO_CR1, pin)
 #define gpioSetAsFloating(port, pin) _gpioSetAsFloating(port, pin)
 
 // Sets an input GPIO pin as pull-up by setting the corresponding CR1 bit to 1.
 // Parameters:
 //    port - The port name as an uppercase letter
 //    pin - The pin of the port to set as pull-up, a number in range [0,7]
-#define _gpioSetAsPullUp(port, pin) registerSet(REGISTER_P##port##_CR1, GPIO_PIN_##pin)
+#define _gpioSetAsPullUp(port, pin) _gpioBitSet(_GPIO_P##port, _GPIO_CR1, pin)
 #define gpioSetAsPullUp(port, pin) _gpioSetAsPullUp(port, pin)
 
 // Sets an output GPIO pin as open drain by setting the corresponding CR1 bit to 0.
 // Parameters:
 //    port - The port name as an uppercase letter
 //    pin - The pin of the port to set as open drain, a number in range [0,7]
-#define _gpioSetAsOpenDrain(port, pin) registerUnset(REGISTER_P##port##_CR1, GPIO_PIN_##pin)
+#define _gpioSetAsOpenDrain(port, pin) _gpioBitReset(_GPIO_P##port, _GPIO_CR1, pin)
 #define gpioSetAsOpenDrain(port, pin) _gpioSetAsOpenDrain(port, pin)
 
 // Sets an output GPIO pin as push-pull by setting the corresponding CR1 bit to 1.
 // Parameters:
 //    port - The port name as an uppercase letter
 //    pin - The pin of the port to set as push-pull, a number in range [0,7]
-#define _gpioSetAsPushPull(port, pin) registerSet(REGISTER_P##port##_CR1, GPIO_PIN_##pin)
+#define _gpioSetAsPushPull(port, pin) _gpioBitSet(_GPIO_P##port, _GPIO_CR1, pin)
 #define gpioSetAsPushPull(port, pin) _gpioSetAsPushPull(port, pin)
 
 // Set an output GPIO pin as high.
 // Parameters:
 //    port - The port name as an uppercase letter
 //    pin - The pin of the port to set as high, a number in range [0,7]
-#define _gpioWriteHigh(port, pin) registerSet(REGISTER_P##port##_ODR, GPIO_PIN_##pin)
+#define _gpioWriteHigh(port, pin) _gpioBitSet(_GPIO_P##port, _GPIO_ODR, pin)
 #define gpioWriteHigh(port, pin) _gpioWriteHigh(port, pin)
 
 // Set an output GPIO pin as low.
 // Parameters:
 //    port - The port name as an uppercase letter
 //    pin - The pin of the port to set as low, a number in range [0,7]
-#define _gpioWriteLow(port, pin) registerUnset(REGISTER_P##port##_ODR, GPIO_PIN_##pin)
+#define _gpioWriteLow(port, pin) _gpioBitReset(_GPIO_P##port, _GPIO_ODR, pin)
 #define gpioWriteLow(port, pin) _gpioWriteLow(port, pin)
 
 // Invert an output GPIO pin.
 // Parameters:
 //    port - The port name as an uppercase letter
 //    pin - The pin of the port to invert, a number in range [0,7]
-#define _gpioInvert(port, pin) registerInvert(REGISTER_P##port##_ODR, GPIO_PIN_##pin)
+#define _gpioInvert(port, pin) _gpioBitComplement(_GPIO_P##port, _GPIO_ODR, pin)
 #define gpioInvert(port, pin) _gpioInvert(port, pin)
 
 // Read the GPIO input pin from the IDR register
@@ -171,6 +206,44 @@
 #define _gpioReadInput(port, pin) (bool)(REGISTER_P##port##_IDR & (uint8_t)GPIO_PIN_##pin)
 #define gpioReadInput(port, pin) _gpioReadInput(port, pin)
 
+// Read all the input pins of a GPIO port at once from the IDR register
+// Parameters:
+//    port - The port name as an uppercase letter
+// Returns:
+//    A uint8_t with one bit per pin of the port
+#define _gpioReadPort(port) (uint8_t)(REGISTER_P##port##_IDR)
+#define gpioReadPort(port) _gpioReadPort(port)
+
+// Read several input pins of a GPIO port at once from the IDR register
+// Parameters:
+//    port - The port name as an uppercase letter
+//    mask - The pins to read, as a mask of gpioPinMask()
+// Returns:
+//    A uint8_t with the bits of the pins in the mask (the others are 0)
+#define _gpioReadMask(port, mask) (uint8_t)(REGISTER_P##port##_IDR & (uint8_t)(mask))
+#define gpioReadMask(port, mask) _gpioReadMask(port, mask)
+
+// Sets and clears several output pins of a GPIO port with a single write of
+// the ODR register, so they all change at the same time. The interrupts are
+// disabled between reading and writing the ODR, so changes of other pins made
+// by interrupts are never lost.
+// Parameters:
+//    port - The port name as an uppercase letter
+//    set - The pins to set high, as a mask of gpioPinMask()
+//    clear - The pins to set low, as a mask of gpioPinMask()
+#define _gpioWriteMask(port, set, clear) do {\
+  __critical {\
+    REGISTER_P##port##_ODR = (uint8_t)((REGISTER_P##port##_ODR & (uint8_t)~(clear)) | (set));\
+  }\
+} while(0)
+#define gpioWriteMask(port, set, clear) _gpioWriteMask(port, set, clear)
+
+// Get the bit mask of a GPIO pin, as used in the port registers
+// Parameters:
+//    pin - The pin number, a number in range [0,7]
+#define _gpioPinMask(pin) GPIO_PIN_##pin
+#define gpioPinMask(pin) _gpioPinMask(pin)
+
 // Read the GPIO output pin from the ODR register
 // Parameters:
 //    port - The port name as an uppercase letter
@@ -202,14 +275,14 @@
 // Parameters:
 //    port - The port name as an uppercase letter
 //    pin - The pin of the port to enable the interrupts for
-#define _gpioEnableInterrupt(port, pin) registerSet(REGISTER_P##port##_CR2, GPIO_PIN_##pin)
+#define _gpioEnableInterrupt(port, pin) _gpioBitSet(_GPIO_P##port, _GPIO_CR2, pin)
 #define gpioEnableInterrupt(port, pin) _gpioEnableInterrupt(port, pin)
 
 // Disable the interrupts for a GPIO pin.
 // Parameters:
 //    port - The port name as an uppercase letter
 //    pin - The pin of the port to disable the interrupts for
-#define _gpioDisableInterrupt(port, pin) registerUnset(REGISTER_P##port##_CR2, GPIO_PIN_##pin)
+#define _gpioDisableInterrupt(port, pin) _gpioBitReset(_GPIO_P##port, _GPIO_CR2, pin)
 #define gpioDisableInterrupt(port, pin) _gpioDisableInterrupt(port, pin)
 
 #endif /* STM8_GPIO_H */
@@ -28,24 +28,31 @@
 #include <stdbool.h>
 #include <stm8.h>
 #include <utils.h>
+#include <clk.h>
+#include <itc.h>
+#include <memory_slave.h>
 
 ///////////////////////////////////////////////////////////////////////////////
 // I2C related registers
 ///////////////////////////////////////////////////////////////////////////////
-#define REGISTER_I2C_CR1 REGISTER    0x5210 // I2C control register 1
-#define REGISTER_I2C_CR2 REGISTER    0x5211 // I2C control register 2
-#define REGISTER_I2C_FREQR REGISTER  0x5212 // I2C frequency register
-#define REGISTER_I2C_OARL REGISTER   0x5213 // I2C own address register low
-#define REGISTER_I2C_OARH REGISTER   0x5214 // I2C own address register high
-#define REGISTER_I2C_DR REGISTER     0x5216 // I2C data register
-#define REGISTER_I2C_SR1 REGISTER    0x5217 // I2C status register 1
-#define REGISTER_I2C_SR2 REGISTER    0x5218 // I2C status register 2
-#define REGISTER_I2C_SR3 REGISTER    0x5219 // I2C status register 3 
-#define REGISTER_I2C_ITR REGISTER    0x521A // I2C interrup control register
-#define REGISTER_I2C_CCRL REGISTER   0x521B // I2C clock control register low
-#define REGISTER_I2C_CCRH REGISTER   0x521C // I2C clock control register high
-#define REGISTER_I2C_TRISER REGISTER 0x521D // I2C TRISE register
-#define REGISTER_I2C_PECR REGISTER   0x521E // I2C packet error checking register
+#define REGISTER_I2C_CR1 REGISTER(0x5210)    // I2C control register 1
+#define REGISTER_I2C_CR2 REGISTER(0x5211)    // I2C control register 2
+#define REGISTER_I2C_FREQR REGISTER(0x5212)  // I2C frequency register
+#define REGISTER_I2C_OARL REGISTER(0x5213)   // I2C own address register low
+#define REGISTER_I2C_OARH REGISTER(0x5214)   // I2C own address register high
+#ifdef STM8_HOST
+#define REGISTER_I2C_DR _STM8_HOST_I2C_DR    // I2C data register (see stm8_host.h)
+#else
+#define REGISTER_I2C_DR REGISTER(0x5216)     // I2C data register
+#endif
+#define REGISTER_I2C_SR1 REGISTER(0x5217)    // I2C status register 1
+#define REGISTER_I2C_SR2 REGISTER(0x5218)    // I2C status register 2
+#define REGISTER_I2C_SR3 REGISTER(0x5219)    // I2C status register 3 
+#define REGISTER_I2C_ITR REGISTER(0x521A)    // I2C interrup control register
+#define REGISTER_I2C_CCRL REGISTER(0x521B)   // I2C clock control register low
+#define REGISTER_I2C_CCRH REGISTER(0x521C)   // I2C clock control register high
+#define REGISTER_I2C_TRISER REGISTER(0x521D) // I2C TRISE register
+#define REGISTER_I2C_PECR REGISTER(0x521E)   // I2C packet error checking register
 
 ///////////////////////////////////////////////////////////////////////////////
 // I2C register flags
@@ -53,6 +60,8 @@
 #define I2C_CR1_NOO_STRETCH (uint8_t) 0b10000000
 #define I2C_CR1_ENGC        (uint8_t) 0b01000000
 #define I2C_CR1_PE          (uint8_t) 0b00000001
+#define I2C_CR2_SWRST       (uint8_t) 0b10000000
+#define I2C_CR2_POS         (uint8_t) 0b00001000
 #define I2C_CR2_ACK         (uint8_t) 0b00000100
 #define I2C_CR2_STOP        (uint8_t) 0b00000010
 #define I2C_CR2_START       (uint8_t) 0b00000001
@@ -85,49 +94,108 @@
 // Macros and methods for handling I2C, to be used by the user
 ///////////////////////////////////////////////////////////////////////////////
 
-// Initializes the I2C peripheral. 
+///////////////////////////////////////////////////////////////////////////////
+// Helper values for computing the clock control of each I2C speed mode. The
+// modes are:
+// - STANDARD: 100 kbit/s, SCL period = 2 * CCR * t_MASTER
+// - FAST: 400 kbit/s, t_low/t_high = 2, SCL period = 3 * CCR * t_MASTER
+// - FAST_DUTY: 400 kbit/s, t_low/t_high = 16/9, SCL period = 25 * CCR * t_MASTER
+// The CCR is rounded up, so the bus never runs faster than the mode speed. The
+// TRISE is the maximum rise time (1000 ns for standard, 300 ns for fast mode)
+// in t_MASTER periods plus one.
+///////////////////////////////////////////////////////////////////////////////
+#define _I2C_CCRH_STANDARD  (uint8_t) 0
+#define _I2C_CCRH_FAST      I2C_CCRH_FS
+#define _I2C_CCRH_FAST_DUTY (uint8_t)(I2C_CCRH_FS | I2C_CCRH_DUTY)
+#define _I2C_CCR_STANDARD(frequency)   ((uint16_t)(frequency) * 5)
+#define _I2C_CCR_FAST(frequency)       (((uint16_t)(frequency) * 5 + 5) / 6)
+#define _I2C_CCR_FAST_DUTY(frequency)  (((uint16_t)(frequency) + 9) / 10)
+#define _I2C_TRISE_STANDARD(frequency)  (uint8_t)((frequency) + 1)
+#define _I2C_TRISE_FAST(frequency)      (uint8_t)((frequency) * 3 / 10 + 1)
+#define _I2C_TRISE_FAST_DUTY(frequency) _I2C_TRISE_FAST(frequency)
+#define _I2C_MIN_FREQUENCY_STANDARD  1
+#define _I2C_MIN_FREQUENCY_FAST      4
+#define _I2C_MIN_FREQUENCY_FAST_DUTY 4
+#define _I2C_MAX_FREQUENCY 24
+
+///////////////////////////////////////////////////////////////////////////////
+// Initialization options, which can be combined with |
+///////////////////////////////////////////////////////////////////////////////
+#define I2C_WAKEUP_FROM_HALT (uint8_t) 0b00000001 // Wake up from halt on own address match
+
+// Initializes the I2C peripheral with the given clock control values. Use the
+// i2cInitialize() or i2cInitializeMode() macros instead, which compute them.
+// Parameters:
+// - address: The own address (7bit)
+// - frequency: The frequency f_master which is fed to the peripheral (in MHz)
+// - ccrh: The CCRH register value (mode bits and the 4 MSB of the CCR)
+// - ccrl: The 8 LSB of the CCR
+// - trise: The TRISER register value
+// - options: The I2C_*** initialization options
+void _i2cInitialize(uint8_t address, uint8_t frequency,
+                    uint8_t ccrh, uint8_t ccrl, uint8_t trise, uint8_t options);
+
+// Initializes the I2C peripheral in the given speed mode. The clock control
+// values are computed at compile time, so the parameters must be constants,
+// and combinations the peripheral cannot do (like fast mode with an f_master
+// lower than 4 MHz) fail to compile. Note that in slave mode the SCL is driven
+// by the master, so the mode only guarantees that the f_master is high enough
+// for the bus speed. The clock control is used when the peripheral is master.
 // Current limitations:
-// - Only normal mode (100 kbit/s) is supported
 // - Only 7-bit addresses are supported
 // Parameters:
 // - address: The own address (7bit)
 // - frequency: The frequency f_master which is fed to the peripheral (in MHz)
-void i2cInitialize(uint8_t address, uint8_t frequency) {
-  uint16_t ccr;
-  
-  // Disable the I2C peripheral
-  registerUnset(REGISTER_I2C_CR1, I2C_CR1_PE);
-  
-  // Set the address
-  registerUnset(REGISTER_I2C_OARH, I2C_OARH_ADDMODE); // Use 7-bit address
-  registerSet(REGISTER_I2C_OARH, I2C_OARH_ADDCONF); // Must always be 1
-  REGISTER_I2C_OARL = (uint8_t)(address << 1); // Write own address
-  
-  // Set the input frequency
-  REGISTER_I2C_FREQR = frequency;
-  
-  // Compute the CCR based on the equation Period(I2C) = 2 * CCR * t_MASTER
-  // CCR = frequency * 1000000 / (2 * 100000) = frequency * 5
-  registerUnset(REGISTER_I2C_CCRH, I2C_CCRH_FS); // Set normal mode
-  ccr = (uint16_t)frequency * 5;
-  REGISTER_I2C_CCRL = (uint8_t)ccr;
-  REGISTER_I2C_CCRH = (uint8_t)(ccr >> 8);
-  
-  // Set the maximum rise time
-  REGISTER_I2C_TRISER = frequency + 1;
-  
-  // Enable the interrupts
-  registerSet(REGISTER_I2C_ITR, I2C_ITR_ITBUFEN);
-  registerSet(REGISTER_I2C_ITR, I2C_ITR_ITEVTEN);
-  registerSet(REGISTER_I2C_ITR, I2C_ITR_ITERREN);
-  
-  // Enable the I2C peripheral
-  registerSet(REGISTER_I2C_CR1, I2C_CR1_PE);
-  
-  // Send ACK after bytes (default I2C expectation)
-  registerSet(REGISTER_I2C_CR2, I2C_CR2_ACK);
-}
+// - mode: One of STANDARD (100 kbit/s), FAST (400 kbit/s with duty cycle 2)
+//         or FAST_DUTY (400 kbit/s with duty cycle 16/9, which reaches exactly
+//         400 kbit/s when the frequency is a multiple of 10 MHz)
+// - options: 0 or I2C_WAKEUP_FROM_HALT, for slaves which halt while idle (see
+//            the i2cHaltWhenIdle())
+#define _i2cInitializeOptions(address, frequency, mode, options) do {\
+  _Static_assert((frequency) >= _I2C_MIN_FREQUENCY_##mode,\
+                 "The f_master is too low for the I2C " #mode " mode");\
+  _Static_assert((frequency) <= _I2C_MAX_FREQUENCY,\
+                 "The I2C peripheral supports up to 24 MHz f_master");\
+  _i2cInitialize(address, frequency,\
+                 _I2C_CCRH_##mode | (uint8_t)(_I2C_CCR_##mode(frequency) >> 8),\
+                 (uint8_t)_I2C_CCR_##mode(frequency),\
+                 _I2C_TRISE_##mode(frequency), options);\
+} while(0)
+#define i2cInitializeOptions(address, frequency, mode, options) _i2cInitializeOptions(address, frequency, mode, options)
+
+// Initializes the I2C peripheral in the given speed mode, without options
+#define i2cInitializeMode(address, frequency, mode) i2cInitializeOptions(address, frequency, mode, 0)
+
+// Initializes the I2C peripheral in standard mode (100 kbit/s). As with the
+// i2cInitializeMode(), the parameters must be constants.
+// Parameters:
+// - address: The own address (7bit)
+// - frequency: The frequency f_master which is fed to the peripheral (in MHz)
+#define i2cInitialize(address, frequency) i2cInitializeMode(address, frequency, STANDARD)
+
+// Enters halt, if there is no transaction on the I2C bus, or waits for the
+// next interrupt otherwise. It is meant for slaves initialized with the
+// I2C_WAKEUP_FROM_HALT, which can call it repeatedly in their main loop, so
+// they go back to halt after the STOP of every transaction. The check is done
+// with the interrupts disabled and both the halt and the wfi enable them, so an
+// address match right before the halt is not lost. Note that the halt stops
+// all the clocks, so the timers and the other peripherals do not run until the
+// wakeup.
+#define i2cHaltWhenIdle() do {\
+  sim();\
+  if (REGISTER_I2C_SR3 & I2C_SR3_BUSY) {\
+    wfi();\
+  } else {\
+    halt();\
+  }\
+} while(0)
+
 
+// The state of the I2C memory slave, which is kept between the I2C events
+typedef struct {
+  _MemorySlaveState memory; // The transport independent state
+  bool read_id; // If the next received byte is the ID
+} _I2cMemorySlaveState;
 
 //
 // This macro implements the I2C interrupt handler in such a way so that it can
@@ -155,75 +223,83 @@ void i2cInitialize(uint8_t address, uint8_t frequency) {
 //
 // Note that if the master keeps sending write bytes after the declared size
 // the are ignored. Similarly, if it keeps reading bytes, zeroes are returned.
+// With a register map (see i2cRegisterMapSlaveInterruptHandler()) the access
+// instead continues with the next mapped ID, so consecutive registers can be
+// read or written in a single transaction.
 //
 // For an example of how to use this macro see the src/i2c_adder_example.c
 //
-void _i2cMemorySlave( uint8_t* (*handleId)(uint8_t, uint8_t*), uint8_t** ptr,
-                     uint8_t* size, bool* read_id) {
-  
-  // Event EV1
-  if (REGISTER_I2C_SR1 & I2C_SR1_ADDR) {
-    REGISTER_I2C_SR3; // Read the SR3 to unblock the I2C
-    *read_id = true; // We just got the address so we set that we want to read the ID
-    return;
-  }
-  
-  // Event EV2
-  if (REGISTER_I2C_SR1 & I2C_SR1_RXNE) {
-    if (*read_id) {
-      // If we are reading the ID use the user method to get the pointer and the size
-      *ptr = (*handleId)(REGISTER_I2C_DR, size);
-      // If we have an unknown ID we do not want to read or write any bytes,
-      // so we set the size to zero
-      if (*ptr == 0) {
-        *size = 0;
-      }
-      *read_id = false; // All rest bytes should be written in memory
-    } else {
-      // Write in memory the byte from I2C, if the size is not 0, otherwise ignore it
-      if (*size > 0) {
-        **ptr = REGISTER_I2C_DR;
-        ++(*ptr);
-        --(*size);
-      }
-    }
-    return;
-  }
-  
-  // Even EV3
-  if (REGISTER_I2C_SR1 & I2C_SR1_TXE) {
-    // Write in I2C the byte from memory if size is not 0, otherwise write 0
-    if (*size > 0) {
-      REGISTER_I2C_DR = **ptr;
-        ++(*ptr);
-        --(*size);
-    } else {
-      REGISTER_I2C_DR = 0;
-    }
-    return;
-  }
-  
-  // Event EV3-2
-  if (REGISTER_I2C_SR2 & I2C_SR2_AF) {
-    registerUnset(REGISTER_I2C_SR2, I2C_SR2_AF);
-    return;
-  }
-  
-  // Event EV4
-  if (REGISTER_I2C_SR1 & I2C_SR1_STOPF) {
-    registerSet(REGISTER_I2C_CR2, I2C_CR2_ACK);
-    return;
-  }
-  
-}
+void _i2cMemorySlave(_I2cMemorySlaveState* state);
 
 #define i2cMemorySlaveIterruptHandler(handleId) \
-uint8_t* _i2c_memory_slave_ptr = 0;\
-uint8_t _i2c_memory_slave_size = 0;\
-bool _i2c_memory_slave_read_id = false;\
+_I2cMemorySlaveState _i2c_memory_slave_state = { { handleId } };\
+void _i2cMemorySlaveInterruptHandler() __interrupt(ITC_IRQ_I2C) {\
+  _i2cMemorySlave(&_i2c_memory_slave_state);\
+}
+
+//
+// This macro implements the same I2C memory slave as the
+// i2cMemorySlaveIterruptHandler(), but all the memory accesses go through a
+// buffer, so multi-byte values are never torn:
+// - When the master starts reading, a snapshot of the memory location is taken
+//   and all the bytes are sent from it
+// - The bytes written by the master are kept in the buffer and they are copied
+//   to the memory location at once, when the STOP (or a repeated START) is
+//   detected
+//
+// The snapshot and the commit are done with the interrupts disabled, so they
+// are consistent with every interrupt, even one with a higher priority than the
+// I2C. The main loop and interrupts of lower priority can be interrupted by the
+// I2C in the middle of an update, so they should update the values they share
+// with the master with a single instruction (like a 16-bit store) or with the
+// interrupts disabled. Memory locations bigger than the buffer are accessed
+// directly.
+//
+// Parameters:
+// - handleId: The function mapping the IDs to memory locations, as for the
+//             i2cMemorySlaveIterruptHandler()
+// - buffer_size: The size of the buffer in bytes, which should be the size of
+//                the biggest exposed variable
+//
+#define i2cBufferedMemorySlaveInterruptHandler(handleId, buffer_size) \
+uint8_t _i2c_memory_slave_buffer[buffer_size];\
+_I2cMemorySlaveState _i2c_memory_slave_state = {\
+  { handleId, 0, 0, _i2c_memory_slave_buffer, buffer_size }\
+};\
+void _i2cMemorySlaveInterruptHandler() __interrupt(ITC_IRQ_I2C) {\
+  _i2cMemorySlave(&_i2c_memory_slave_state);\
+}
+
+//
+// This macro implements the same buffered I2C memory slave as the
+// i2cBufferedMemorySlaveInterruptHandler(), but instead of calling a user
+// function for every ID, the memory locations are taken from a register map
+// (see regmap.h). The lookup is a binary search in a constant table, so the
+// interrupt is shorter and the clock is stretched less. Writes to the
+// registers declared as REGMAP_READ_ONLY are ignored.
+//
+// When the bytes of a register are used up, the access continues with the next
+// mapped ID (unmapped IDs are skipped), so a single transaction can read or
+// write a block of consecutive registers. If the first ID is unmapped, zeroes
+// are returned as usual. Every register is snapshot separately, when its first
+// byte is read, and committed separately, when the master continues to the
+// next register or sends the STOP.
+//
+// Parameters:
+// - map: The constant RegmapEntry array with the registers
+// - buffer_size: The size of the buffer in bytes, which should be the size of
+//                the biggest register
+//
+// For an example of how to use this macro see the
+// src/programs/WheelSpeedReader.c
+//
+#define i2cRegisterMapSlaveInterruptHandler(map, buffer_size) \
+uint8_t _i2c_memory_slave_buffer[buffer_size];\
+_I2cMemorySlaveState _i2c_memory_slave_state = {\
+  { 0, map, regmapLength(map), _i2c_memory_slave_buffer, buffer_size }\
+};\
 void _i2cMemorySlaveInterruptHandler() __interrupt(ITC_IRQ_I2C) {\
-  _i2cMemorySlave(handleId, &_i2c_memory_slave_ptr,\
-                  &_i2c_memory_slave_size, &_i2c_memory_slave_read_id);\
+  _i2cMemorySlave(&_i2c_memory_slave_state);\
 }
 
 #endif /* STM8_I2C_H */
@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   i2c_master.h
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#ifndef STM8_I2C_MASTER_H
+#define STM8_I2C_MASTER_H
+
+#include <stdbool.h>
+#include <stm8.h>
+#include <utils.h>
+#include <i2c.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// The size of the transaction queue. It must be a power of two, up to 128, and
+// it is set in the Makefile.
+///////////////////////////////////////////////////////////////////////////////
+#ifdef I2C_MASTER_QUEUE_SIZE
+#error "I2C_MASTER_QUEUE_SIZE must be set in the Makefile, as the library is compiled with it"
+#endif
+#ifdef _STM8_I2C_MASTER_QUEUE_SIZE
+#define I2C_MASTER_QUEUE_SIZE _STM8_I2C_MASTER_QUEUE_SIZE
+#else
+#define I2C_MASTER_QUEUE_SIZE 4
+#endif
+#if (I2C_MASTER_QUEUE_SIZE) & ((I2C_MASTER_QUEUE_SIZE) - 1) || (I2C_MASTER_QUEUE_SIZE) < 1 || (I2C_MASTER_QUEUE_SIZE) > 128
+#error "I2C_MASTER_QUEUE_SIZE must be a power of two, up to 128"
+#endif
+#define _I2C_MASTER_QUEUE_MASK (uint8_t)(I2C_MASTER_QUEUE_SIZE - 1)
+
+///////////////////////////////////////////////////////////////////////////////
+// The status of an I2C master transaction
+///////////////////////////////////////////////////////////////////////////////
+#define I2C_TRANSACTION_PENDING 0 // Queued or in progress
+#define I2C_TRANSACTION_DONE    1 // Finished successfully
+#define I2C_TRANSACTION_ERROR   2 // NACK, arbitration lost or bus error
+
+// An I2C master transaction. The bytes of the write buffer are sent first and
+// then, if the read size is not zero, the read buffer is filled after a
+// repeated START. The buffers and the transaction must stay valid until the
+// status is not I2C_TRANSACTION_PENDING anymore.
+typedef struct {
+  uint8_t address; // The 7-bit address of the slave
+  uint8_t* write_data; // The bytes to write
+  uint8_t write_size; // The number of bytes to write (can be 0)
+  uint8_t* read_data; // The buffer to store the read bytes
+  uint8_t read_size; // The number of bytes to read (can be 0)
+  volatile uint8_t status; // One of the I2C_TRANSACTION_***
+} I2cTransaction;
+
+// The state of the I2C master, which is kept between the I2C events
+typedef struct {
+  I2cTransaction* queue[I2C_MASTER_QUEUE_SIZE]; // The queued transactions
+  uint8_t head; // The index of the current transaction
+  uint8_t tail; // The index where the next transaction is queued
+  uint8_t* ptr; // The next byte to write or read
+  uint8_t remaining; // The number of bytes left in the current phase
+  bool reading; // If the current phase is the read phase
+  bool busy; // If a transaction is in progress
+  bool restarting; // If a repeated START was requested for the next transaction
+  bool starting; // If the phase waits for its SB event
+} _I2cMasterState;
+
+// The master state, which is defined by the i2cMasterInterruptHandler() macro
+extern _I2cMasterState _i2c_master_state;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Macros and methods for handling I2C in master mode, to be used by the user
+///////////////////////////////////////////////////////////////////////////////
+
+// Prepares the state for the current phase of the current transaction, which
+// waits for its START. The ACK and POS bits are set and the buffer interrupts
+// are enabled at the SB event, as the CR2 must not be written while a START or
+// STOP request is pending.
+void _i2cMasterSetupPhase(_I2cMasterState* state);
+
+// Starts the transaction at the head of the queue. If the previous transaction
+// ended with a repeated START it is already requested, otherwise the START is
+// requested after the STOP of the previous transaction is generated. Waiting
+// for the STOP is needed only when the master was idle, or when a transaction
+// is queued after the STOP of a single byte read was already requested.
+void _i2cMasterBegin(_I2cMasterState* state);
+
+// Ends the current transaction on the bus. If another transaction is queued a
+// repeated START is requested, so the next one starts without waiting for a
+// STOP. Otherwise, if the stop is true, the STOP is requested. After a lost
+// arbitration the peripheral is already a slave, so no STOP is sent and the
+// START of the next transaction is generated when the bus becomes free.
+void _i2cMasterRelease(_I2cMasterState* state, bool stop);
+
+// Sets the status of the current transaction and starts the next one, if any.
+// The bus must already be released with the _i2cMasterRelease().
+void _i2cMasterFinish(_I2cMasterState* state, uint8_t status);
+
+// Queues a transaction. If the master is idle the transaction starts
+// immediately, otherwise it starts when the previous ones are finished. The
+// method does not wait for the transaction, the caller must check its status.
+// Returns false if the queue is full.
+bool _i2cMasterSubmit(_I2cMasterState* state, I2cTransaction* transaction);
+
+//
+// The I2C master state machine, as described in the STM8S reference manual
+// sections 21.4.7 and 21.4.8. It is driven only by the I2C events, so the CPU
+// never waits for the status flags:
+// - EV5 (SB): The START was sent, so we set the ACK and POS of the phase and
+//   send the address. Until then the flags of the previous phase are still
+//   set and the events are ignored.
+// - EV6 (ADDR): The slave acknowledged the address
+// - EV8 (TXE): The next byte can be written
+// - EV8_2 (BTF): The last byte was sent, so we generate a repeated START for
+//   the read phase or the STOP
+// - EV7 (RXNE): A byte was received
+// The last three bytes of a read are handled with the BTF events (with the
+// buffer interrupts disabled), so the NACK of the last byte and the STOP are
+// set while the clock is stretched and do not depend on the interrupt latency.
+// Queued transactions follow each other with a repeated START, so the
+// interrupt never waits for a STOP to be generated.
+//
+void _i2cMaster(_I2cMasterState* state);
+
+//
+// This macro implements the I2C interrupt handler for the master mode. The
+// peripheral must first be initialized with the i2cInitializeMode(), which
+// sets the bus speed. Then transactions can be queued with the
+// i2cMasterSubmit(), which returns immediately. The status of each transaction
+// becomes I2C_TRANSACTION_DONE or I2C_TRANSACTION_ERROR when it is finished.
+//
+// Warning: This handler cannot be combined with the memory slave handlers, as
+// there is a single I2C interrupt.
+//
+// For an example of how to use this macro see the
+// src/examples/i2c_master_example.c
+//
+#define i2cMasterInterruptHandler() \
+_I2cMasterState _i2c_master_state;\
+void _i2cMasterInterruptHandler() __interrupt(ITC_IRQ_I2C) {\
+  _i2cMaster(&_i2c_master_state);\
+}
+
+// Queues an I2C master transaction. It can only be used together with the
+// i2cMasterInterruptHandler() macro.
+// Parameters:
+// - transaction: A pointer to the I2cTransaction
+// Returns:
+//    true if the transaction was queued, false if the queue is full
+#define i2cMasterSubmit(transaction) _i2cMasterSubmit(&_i2c_master_state, transaction)
+
+#endif /* STM8_I2C_MASTER_H */
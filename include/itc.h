@@ -59,17 +59,17 @@
 // Interrupt registers
 ///////////////////////////////////////////////////////////////////////////////
 // Software Priority Registers
-#define REGISTER_ITC_SPR1 REGISTER 0x7F70
-#define REGISTER_ITC_SPR2 REGISTER 0x7F71
-#define REGISTER_ITC_SPR3 REGISTER 0x7F72
-#define REGISTER_ITC_SPR4 REGISTER 0x7F73
-#define REGISTER_ITC_SPR5 REGISTER 0x7F74
-#define REGISTER_ITC_SPR6 REGISTER 0x7F75
-#define REGISTER_ITC_SPR7 REGISTER 0x7F76
-#define REGISTER_ITC_SPR8 REGISTER 0x7F77
+#define REGISTER_ITC_SPR1 REGISTER(0x7F70)
+#define REGISTER_ITC_SPR2 REGISTER(0x7F71)
+#define REGISTER_ITC_SPR3 REGISTER(0x7F72)
+#define REGISTER_ITC_SPR4 REGISTER(0x7F73)
+#define REGISTER_ITC_SPR5 REGISTER(0x7F74)
+#define REGISTER_ITC_SPR6 REGISTER(0x7F75)
+#define REGISTER_ITC_SPR7 REGISTER(0x7F76)
+#define REGISTER_ITC_SPR8 REGISTER(0x7F77)
 // External interrupt control registers
-#define REGISTER_EXTI_CR1 REGISTER 0x50A0
-#define REGISTER_EXTI_CR2 REGISTER 0x50A1
+#define REGISTER_EXTI_CR1 REGISTER(0x50A0)
+#define REGISTER_EXTI_CR2 REGISTER(0x50A1)
 
 ///////////////////////////////////////////////////////////////////////////////
 // The SPR register each interrupt is configured in
@@ -175,11 +175,14 @@
 ///////////////////////////////////////////////////////////////////////////////
 // STM8S interrupt related assembly shortcuts
 ///////////////////////////////////////////////////////////////////////////////
+#ifndef STM8_HOST
 #define rim() {__asm__("rim\n");} // Enable interrupts
-#define enableInterrupts() rim() // Alias for enable interrupts
 #define sim() {__asm__("sim\n");} // Disable interrupts
-#define disableInterrupts() sim() // Alias for disable interrupts
 #define wfi() {__asm__("wfi\n");} // Wait for interrupt
+#define halt() {__asm__("halt\n");} // Stop all the clocks until an external interrupt or the AWU
+#endif
+#define enableInterrupts() rim() // Alias for enable interrupts
+#define disableInterrupts() sim() // Alias for disable interrupts
 #define waitForInterrupt() wfi() // Alias for wait for interrupt
 
 
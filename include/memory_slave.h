@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   memory_slave.h
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#ifndef STM8_MEMORY_SLAVE_H
+#define STM8_MEMORY_SLAVE_H
+
+#include <stdbool.h>
+#include <stm8.h>
+#include <regmap.h>
+
+//
+// The memory slave exposes memory locations, identified by an 8bit ID, to a
+// bus master. The IDs are mapped to memory locations either by a user function
+// or by a register map (see regmap.h). This file contains the part which does
+// not depend on the bus, so the same memory can be served by the I2C (see
+// i2c.h) or by the SPI (see spi_slave.h). The transports select an ID and then
+// move the bytes one by one with the _memorySlaveWrite() and _memorySlaveRead().
+//
+
+// The state of the memory slave. The first fields are the configuration, set
+// by the handler macros of the transports.
+typedef struct {
+  uint8_t* (*handle_id)(uint8_t, uint8_t*); // The user ID function (or 0)
+  const RegmapEntry* map; // The register map (or 0)
+  uint16_t map_length; // The number of registers in the register map
+  uint8_t* buffer; // The snapshot/shadow buffer (0 for direct access)
+  uint8_t buffer_size; // The size of the buffer
+  uint8_t* ptr; // The next byte to read or write
+  uint8_t size; // The number of bytes left to read or write
+  uint8_t id; // The current ID
+  uint16_t index; // The register map entry of the current ID (if mapped)
+  uint8_t* target; // The memory location of the current ID
+  uint8_t length; // The size of the memory location of the current ID
+  bool buffered; // If the current ID is accessed via the buffer
+  bool read_only; // If the master is not allowed to write the current ID
+  uint8_t written; // The number of bytes written in the buffer
+} _MemorySlaveState;
+
+// Copies the bytes written by the master in the buffer to the memory, with the
+// interrupts disabled
+void _memorySlaveCommit(_MemorySlaveState* state);
+
+// Copies the memory of the current ID in the buffer, so all the bytes sent to
+// the master belong to the same value. The copy is done with the interrupts
+// disabled.
+void _memorySlaveSnapshot(_MemorySlaveState* state);
+
+// Sets up the access of the memory location of the current ID. Unknown IDs get
+// the size 0 and the memory is accessed via the buffer, if it fits. It is a
+// macro, so it adds no call to the interrupt handlers.
+#define _memorySlaveAccess(state) do {\
+  if ((state)->target == 0) {\
+    (state)->size = 0;\
+  }\
+  (state)->length = (state)->size;\
+  (state)->buffered = (state)->size > 0 && (state)->size <= (state)->buffer_size;\
+  (state)->ptr = (state)->buffered ? (state)->buffer : (state)->target;\
+} while(0)
+
+// Sets the register of the given register map entry as the one to be accessed.
+// It is a macro, so it adds no call to the interrupt handlers.
+#define _memorySlaveSelectEntry(state, entry) do {\
+  (state)->id = regmapId((state)->map, entry);\
+  (state)->index = (entry);\
+  (state)->target = regmapPointer((state)->map, entry);\
+  (state)->size = regmapSize((state)->map, entry);\
+  (state)->read_only = regmapIsReadOnly((state)->map, entry);\
+  _memorySlaveAccess(state);\
+} while(0)
+
+// Sets the memory location of the given ID as the one to be accessed. With a
+// register map the ID is found with a binary search, which is done in place,
+// so selecting an ID costs a single call from the transport.
+void _memorySlaveSelect(_MemorySlaveState* state, uint8_t id);
+
+// Moves to the next mapped ID of the register map, after the bytes of the
+// current one are used up. The bytes written to the current ID are committed
+// first. The register maps are sorted, so the next ID is just the next entry of
+// the table. Returns false if there is no mapped ID after the current one.
+bool _memorySlaveNext(_MemorySlaveState* state);
+
+// Writes a byte received from the master in the memory of the current ID. If
+// the size is 0 or the master is not allowed to write, the byte is ignored.
+// With a register map the writing continues to the next register.
+void _memorySlaveWrite(_MemorySlaveState* state, uint8_t data);
+
+// Reads the next byte of the current ID, to be sent to the master. If the size
+// is 0, zero is returned. With a register map the reading continues to the
+// next register, taking its snapshot.
+uint8_t _memorySlaveRead(_MemorySlaveState* state);
+
+#endif /* STM8_MEMORY_SLAVE_H */
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   regmap.h
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#ifndef STM8_REGMAP_H
+#define STM8_REGMAP_H
+
+#include <stdbool.h>
+#include <stm8.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Register access flags
+///////////////////////////////////////////////////////////////////////////////
+#define REGMAP_READ_WRITE (uint8_t) 0b00000000 // The master can read and write
+#define REGMAP_READ_ONLY  (uint8_t) 0b10000000 // Writes from the master are ignored
+#define _REGMAP_SIZE_MASK (uint8_t) 0b01111111
+
+// A register of the map. The size and the flags are packed in a single byte,
+// so every entry takes four bytes of flash.
+typedef struct {
+  uint8_t id; // The register ID
+  uint8_t* ptr; // The memory location of the register
+  uint8_t info; // The size in bytes (up to 127) and the REGMAP_*** flags
+} RegmapEntry;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Macros for declaring register maps, to be used by the user
+///////////////////////////////////////////////////////////////////////////////
+
+//
+// A register map is a constant array of RegmapEntry (which is placed in flash)
+// with one entry per register, sorted by the register ID. Looking up an ID is a
+// binary search, which takes at most 8 steps for any map and is done inside
+// the interrupt handler, without further calls. It is declared with one
+// regmapRegister() per register, in increasing ID order (see the
+// regmapIsSorted()):
+//
+//   const RegmapEntry registers[] = {
+//     regmapRegister(0x01, var1, REGMAP_READ_WRITE),
+//     regmapRegister(0x02, var2, REGMAP_READ_ONLY)
+//   };
+//
+// The IDs which are not declared are unmapped. They take no space, so the IDs
+// can be grouped freely (for example 0x1n, 0x2n, ...).
+//
+
+// Declares a register of a register map
+// Parameters:
+// - id: The register ID (0-255)
+// - variable: The variable exposed as the register. Its size is taken with
+//             sizeof, so it must be a variable and not a pointer to it.
+// - flags: One of REGMAP_READ_WRITE or REGMAP_READ_ONLY
+#define regmapRegister(id, variable, flags) \
+  { id, (uint8_t*)&(variable), (uint8_t)(sizeof(variable) | (flags)) }
+
+// Returns the number of registers of a register map
+#define regmapLength(map) (uint16_t)(sizeof(map) / sizeof(RegmapEntry))
+
+// Checks that the IDs of a register map are strictly increasing. The lookup
+// does not find the registers of an unsorted map, and the compiler cannot check
+// the order, so the host harness of every program using a map should check it
+// (see src/host/wheel_replay.c).
+// Parameters:
+// - map: The RegmapEntry array
+// - length: The number of registers of the map
+// Returns:
+//    true if the map is sorted
+bool regmapIsSorted(const RegmapEntry* map, uint16_t length);
+
+// Gets the ID of the register with the given index
+#define regmapId(map, index) ((map)[index].id)
+
+// Gets the memory location of the register with the given index
+#define regmapPointer(map, index) ((map)[index].ptr)
+
+// Gets the size in bytes of the register with the given index
+#define regmapSize(map, index) (uint8_t)((map)[index].info & _REGMAP_SIZE_MASK)
+
+// Checks if the register with the given index is read-only
+#define regmapIsReadOnly(map, index) (bool)((map)[index].info & REGMAP_READ_ONLY)
+
+#endif /* STM8_REGMAP_H */
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   spi.h
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#ifndef STM8_SPI_H
+#define STM8_SPI_H
+
+#include <stm8.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// SPI registers
+///////////////////////////////////////////////////////////////////////////////
+#define REGISTER_SPI_CR1    REGISTER(0x5200) // Control register 1
+#define REGISTER_SPI_CR2    REGISTER(0x5201) // Control register 2
+#define REGISTER_SPI_ICR    REGISTER(0x5202) // Interrupt control register
+#define REGISTER_SPI_SR     REGISTER(0x5203) // Status register
+#define REGISTER_SPI_DR     REGISTER(0x5204) // Data register
+#define REGISTER_SPI_CRCPR  REGISTER(0x5205) // CRC polynomial register
+#define REGISTER_SPI_RXCRCR REGISTER(0x5206) // Rx CRC register
+#define REGISTER_SPI_TXCRCR REGISTER(0x5207) // Tx CRC register
+
+///////////////////////////////////////////////////////////////////////////////
+// SPI register flags
+///////////////////////////////////////////////////////////////////////////////
+#define SPI_CR1_LSBFIRST (uint8_t) 0b10000000 // Frame format (LSB first)
+#define SPI_CR1_SPE      (uint8_t) 0b01000000 // SPI enable
+#define SPI_CR1_MSTR     (uint8_t) 0b00000100 // Master selection
+#define SPI_CR1_CPOL     (uint8_t) 0b00000010 // Clock polarity
+#define SPI_CR1_CPHA     (uint8_t) 0b00000001 // Clock phase
+#define SPI_CR2_BDM      (uint8_t) 0b10000000 // Bidirectional data mode enable
+#define SPI_CR2_BDOE     (uint8_t) 0b01000000 // Output enable in bidirectional mode
+#define SPI_CR2_CRCEN    (uint8_t) 0b00100000 // Hardware CRC calculation enable
+#define SPI_CR2_CRCNEXT  (uint8_t) 0b00010000 // Transmit CRC next
+#define SPI_CR2_RXONLY   (uint8_t) 0b00000100 // Receive only
+#define SPI_CR2_SSM      (uint8_t) 0b00000010 // Software slave management
+#define SPI_CR2_SSI      (uint8_t) 0b00000001 // Internal slave select
+#define SPI_ICR_TXIE     (uint8_t) 0b10000000 // Tx buffer empty interrupt enable
+#define SPI_ICR_RXIE     (uint8_t) 0b01000000 // Rx buffer not empty interrupt enable
+#define SPI_ICR_ERRIE    (uint8_t) 0b00100000 // Error interrupt enable
+#define SPI_ICR_WKIE     (uint8_t) 0b00010000 // Wakeup interrupt enable
+#define SPI_SR_BSY       (uint8_t) 0b10000000 // Busy flag
+#define SPI_SR_OVR       (uint8_t) 0b01000000 // Overrun flag
+#define SPI_SR_MODF      (uint8_t) 0b00100000 // Mode fault
+#define SPI_SR_CRCERR    (uint8_t) 0b00010000 // CRC error flag
+#define SPI_SR_WKUP      (uint8_t) 0b00001000 // Wakeup flag
+#define SPI_SR_TXE       (uint8_t) 0b00000010 // Transmit buffer empty
+#define SPI_SR_RXNE      (uint8_t) 0b00000001 // Receive buffer not empty
+
+///////////////////////////////////////////////////////////////////////////////
+// SPI modes (clock polarity and phase)
+///////////////////////////////////////////////////////////////////////////////
+#define SPI_MODE_0 (uint8_t) 0 // Clock idle low, sample on the rising edge
+#define SPI_MODE_1 SPI_CR1_CPHA // Clock idle low, sample on the falling edge
+#define SPI_MODE_2 SPI_CR1_CPOL // Clock idle high, sample on the falling edge
+#define SPI_MODE_3 (uint8_t)(SPI_CR1_CPOL | SPI_CR1_CPHA) // Clock idle high, sample on the rising edge
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper values for computing the baud rate prescaler. The SCK frequency is
+// f_master / 2^(BR + 1) and we select the smallest prescaler which does not
+// exceed the requested frequency. The value 8 means that no prescaler is slow
+// enough.
+///////////////////////////////////////////////////////////////////////////////
+#define _SPI_BR_SHIFT 3
+#define _SPI_BR(frequency, sck_khz) (\
+  (uint32_t)(frequency) * 1000 / 2 <= (sck_khz) ? 0 :\
+  (uint32_t)(frequency) * 1000 / 4 <= (sck_khz) ? 1 :\
+  (uint32_t)(frequency) * 1000 / 8 <= (sck_khz) ? 2 :\
+  (uint32_t)(frequency) * 1000 / 16 <= (sck_khz) ? 3 :\
+  (uint32_t)(frequency) * 1000 / 32 <= (sck_khz) ? 4 :\
+  (uint32_t)(frequency) * 1000 / 64 <= (sck_khz) ? 5 :\
+  (uint32_t)(frequency) * 1000 / 128 <= (sck_khz) ? 6 :\
+  (uint32_t)(frequency) * 1000 / 256 <= (sck_khz) ? 7 : 8)
+
+#endif /* STM8_SPI_H */
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   spi_master.h
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#ifndef STM8_SPI_MASTER_H
+#define STM8_SPI_MASTER_H
+
+#include <stdbool.h>
+#include <stm8.h>
+#include <utils.h>
+#include <spi.h>
+
+// The state of the SPI master transfer, which is kept between the SPI events
+typedef struct {
+  void (*on_complete)(void); // The user function called at the end (or 0)
+  const uint8_t* tx; // The bytes to send (or 0 to send 0xFF)
+  uint8_t* rx; // The buffer for the received bytes (or 0 to ignore them)
+  uint8_t size; // The number of bytes of the transfer
+  uint8_t tx_count; // The number of bytes written in the DR
+  uint8_t rx_count; // The number of bytes read from the DR
+  volatile bool busy; // If a transfer is in progress
+} _SpiMasterState;
+
+// The SPI master state, which is defined by the spiMasterInterruptHandler()
+extern _SpiMasterState _spi_master_state;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Macros and methods for handling the SPI, to be used by the user
+///////////////////////////////////////////////////////////////////////////////
+
+// Initializes the SPI as master with the given CR1 configuration. Use the
+// spiInitializeMaster() macro instead, which computes it.
+void _spiInitializeMaster(uint8_t cr1);
+
+// Initializes the SPI as master (SCK on C5, MOSI on C6, MISO on C7), sending
+// the MSB first. The prescaler is computed at compile time, as the fastest one
+// which does not exceed the requested SCK frequency, so the parameters must be
+// constants. Note that at the fastest SCK frequencies a byte takes only a few
+// CPU cycles, so the transfers are limited by the interrupt handling. Slaves
+// must be selected with GPIOs.
+// Parameters:
+// - frequency: The frequency f_master which is fed to the peripheral (in MHz)
+// - sck_khz: The maximum SCK frequency (in kHz)
+// - mode: One of SPI_MODE_0, SPI_MODE_1, SPI_MODE_2 or SPI_MODE_3
+#define spiInitializeMaster(frequency, sck_khz, mode) do {\
+  _Static_assert(_SPI_BR(frequency, sck_khz) < 8,\
+                 "The SCK frequency is too low for the f_master");\
+  _spiInitializeMaster((uint8_t)(_SPI_BR(frequency, sck_khz) << _SPI_BR_SHIFT) | (mode));\
+} while(0)
+
+// Starts a full-duplex transfer. The method returns immediately and the bytes
+// are transferred by the SPI interrupt. The interrupt writes the first two
+// bytes at once (the second waits in the DR while the first is shifted out)
+// and then the next byte every time one is received, so the clock keeps
+// running between the bytes.
+// Parameters:
+// - tx: The bytes to send, or 0 to send 0xFF bytes
+// - rx: The buffer for the received bytes, or 0 to ignore them
+// - size: The number of bytes to transfer
+// Returns:
+//    false if a transfer is already in progress, true otherwise
+bool _spiTransfer(_SpiMasterState* state, const uint8_t* tx, uint8_t* rx, uint8_t size);
+#define spiTransfer(tx, rx, size) _spiTransfer(&_spi_master_state, tx, rx, size)
+
+// Returns true while a transfer is in progress
+#define spiIsBusy() (_spi_master_state.busy)
+
+// Handles the SPI events of a master transfer. Every pending event is handled
+// before returning, so at high SCK frequencies a single interrupt can move
+// several bytes.
+void _spiMaster(_SpiMasterState* state);
+
+//
+// This macro implements the SPI interrupt handler for the master transfers.
+// Parameters:
+// - onComplete: A function without parameters, which is called from the
+//               interrupt when a transfer is finished, or 0. The spiIsBusy()
+//               can be used instead, for checking if the transfer is finished.
+//
+// For an example of how to use this macro see the src/examples/spi_example.c
+//
+#define spiMasterInterruptHandler(onComplete) \
+_SpiMasterState _spi_master_state = { onComplete };\
+void _spiMasterInterruptHandler() __interrupt(ITC_IRQ_SPI) {\
+  _spiMaster(&_spi_master_state);\
+}
+
+#endif /* STM8_SPI_MASTER_H */
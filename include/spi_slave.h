@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   spi_slave.h
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#ifndef STM8_SPI_SLAVE_H
+#define STM8_SPI_SLAVE_H
+
+#include <stdbool.h>
+#include <stm8.h>
+#include <utils.h>
+#include <gpio.h>
+#include <itc.h>
+#include <spi.h>
+#include <memory_slave.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// The commands of the SPI memory slave (the first byte of every frame)
+///////////////////////////////////////////////////////////////////////////////
+#define SPI_MEMORY_SLAVE_WRITE (uint8_t) 0x02 // Write bytes starting at an ID
+#define SPI_MEMORY_SLAVE_READ  (uint8_t) 0x03 // Read bytes starting at an ID
+
+// The position in the frame of the first byte the slave sends for a read
+#define _SPI_MEMORY_SLAVE_READ_POSITION 3
+
+// The state of the SPI memory slave, which is kept between the SPI events
+typedef struct {
+  _MemorySlaveState memory; // The transport independent state
+  uint8_t command; // The command of the current frame
+  uint8_t rx_position; // The position of the next received byte (up to 2)
+  uint8_t tx_position; // The position of the next byte written in the DR (up to 3)
+} _SpiMemorySlaveState;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Macros and methods for handling the SPI memory slave, to be used by the user
+///////////////////////////////////////////////////////////////////////////////
+
+// Initializes the SPI as slave (SCK on C5, MOSI on C6, MISO on C7, NSS on A3).
+// The end of the frames is detected with the rising edge of the NSS, so the
+// Port A external interrupt is used and the other pins of the Port A should
+// not have their interrupts enabled. It must be called before the interrupts
+// are enabled, because the port sensitivity can only be set while they are
+// disabled.
+// Parameters:
+// - mode: One of SPI_MODE_0, SPI_MODE_1, SPI_MODE_2 or SPI_MODE_3
+void spiInitializeSlave(uint8_t mode);
+
+// Handles a byte received from the master
+void _spiMemorySlaveReceive(_SpiMemorySlaveState* state, uint8_t data);
+
+// Handles the SPI events. The DR is always kept one byte ahead, so the byte
+// written when the TXE is set is sent at the next position of the frame.
+void _spiMemorySlave(_SpiMemorySlaveState* state);
+
+// Handles the end of a frame (the rising edge of the NSS)
+void _spiMemorySlaveEnd(_SpiMemorySlaveState* state);
+
+//
+// This macro implements the SPI memory slave, which serves the same memory
+// locations as the i2cMemorySlaveIterruptHandler(), but over the SPI. Every
+// frame (from the falling to the rising edge of the NSS) is a single access:
+// - Write: The master sends SPI_MEMORY_SLAVE_WRITE, the ID and then the bytes
+//   to be written in sequential locations
+// - Read: The master sends SPI_MEMORY_SLAVE_READ, the ID and a dummy byte,
+//   while the slave prepares the data. The values are returned sequentially
+//   from the fourth byte of the frame on.
+// The bytes the slave sends at the positions 0-1 (with the command and the ID)
+// are undefined and must be ignored by the master. The SPI cannot flush its
+// transmit pipeline at the end of a frame, so they can be bytes prepared for
+// the previous frame, like the next bytes of a read. The bytes at all the
+// other positions without read data are 0xFF.
+//
+// Every byte is handled by the SPI interrupt, so the master must give the
+// slave the time of an interrupt for every byte, either with a low enough SCK
+// or with pauses between the bytes. The interrupt must have the same priority
+// as the Port A interrupt, which detects the end of the frames.
+//
+// Parameters:
+// - handleId: The function mapping the IDs to memory locations, as for the
+//             i2cMemorySlaveIterruptHandler()
+//
+// For an example of how to use this macro see the
+// src/examples/spi_slave_example.c
+//
+#define spiMemorySlaveInterruptHandler(handleId) \
+_SpiMemorySlaveState _spi_memory_slave_state = { { handleId }, 0, 0, 1 };\
+_spiMemorySlaveInterruptHandlers()
+
+//
+// This macro implements the same SPI memory slave as the
+// spiMemorySlaveInterruptHandler(), but all the memory accesses go through a
+// buffer, so multi-byte values are never torn, like with the
+// i2cBufferedMemorySlaveInterruptHandler(). The written bytes are committed
+// at the end of the frame.
+//
+// Parameters:
+// - handleId: The function mapping the IDs to memory locations, as for the
+//             i2cMemorySlaveIterruptHandler()
+// - buffer_size: The size of the buffer in bytes, which should be the size of
+//                the biggest exposed variable
+//
+#define spiBufferedMemorySlaveInterruptHandler(handleId, buffer_size) \
+uint8_t _spi_memory_slave_buffer[buffer_size];\
+_SpiMemorySlaveState _spi_memory_slave_state = {\
+  { handleId, 0, 0, _spi_memory_slave_buffer, buffer_size }, 0, 0, 1\
+};\
+_spiMemorySlaveInterruptHandlers()
+
+//
+// This macro implements the same buffered SPI memory slave as the
+// spiBufferedMemorySlaveInterruptHandler(), but the memory locations are taken
+// from a register map (see regmap.h), so the same map can be served by both
+// the I2C (see i2cRegisterMapSlaveInterruptHandler()) and the SPI. When the
+// bytes of a register are used up, the access continues with the next mapped
+// ID, so a single frame can read or write a block of consecutive registers.
+//
+// Parameters:
+// - map: The constant RegmapEntry array with the registers
+// - buffer_size: The size of the buffer in bytes, which should be the size of
+//                the biggest register
+//
+#define spiRegisterMapSlaveInterruptHandler(map, buffer_size) \
+uint8_t _spi_memory_slave_buffer[buffer_size];\
+_SpiMemorySlaveState _spi_memory_slave_state = {\
+  { 0, map, regmapLength(map), _spi_memory_slave_buffer, buffer_size }, 0, 0, 1\
+};\
+_spiMemorySlaveInterruptHandlers()
+
+// The interrupt handlers used by all the SPI memory slave macros
+#define _spiMemorySlaveInterruptHandlers() \
+void _spiMemorySlaveInterruptHandler() __interrupt(ITC_IRQ_SPI) {\
+  _spiMemorySlave(&_spi_memory_slave_state);\
+}\
+void _spiMemorySlaveEndInterruptHandler() __interrupt(ITC_IRQ_PORTA) {\
+  _spiMemorySlaveEnd(&_spi_memory_slave_state);\
+}
+
+#endif /* STM8_SPI_SLAVE_H */
@@ -27,6 +27,10 @@
 
 #include <stdint.h>
 
+#ifdef STM8_HOST
+#include <stm8_host.h>
+#endif
+
 
 #define TEST
 ///////////////////////////////////////////////////////////////////////////////
@@ -41,7 +45,9 @@
 ///////////////////////////////////////////////////////////////////////////////
 // STM8S useful assembly shortcuts
 ///////////////////////////////////////////////////////////////////////////////
+#ifndef STM8_HOST
 #define nop() {__asm__("nop\n");} // No Operation
+#endif
 
 
 #endif /* STM8_H */
@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   stm8_host.h
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+// Support for building the headers on the host (Linux) with a normal C
+// compiler, which is enabled by defining STM8_HOST. It is included by the
+// stm8.h and should not be included directly.
+//
+// All the registers are kept in an emulated register file, which is plain
+// memory: the hardware does not set or clear any flag. A harness plays the
+// role of the hardware by setting the registers with the hooks below and then
+// calling the interrupt handlers, which are normal functions on the host.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef STM8_HOST_H
+#define STM8_HOST_H
+
+#include <stdint.h>
+#include <string.h>
+
+// The addresses covered by the register file, which are the peripheral
+// registers (from 0x5000) up to the CPU and ITC registers (up to 0x7FFF)
+#define STM8_HOST_REGISTERS_START 0x5000
+#define STM8_HOST_REGISTERS_SIZE  0x3000
+
+// The emulated register file, which is defined by the stm8HostRegisterFile()
+extern volatile uint8_t _stm8_host_registers[STM8_HOST_REGISTERS_SIZE];
+
+// The I2C data register is accessed through this hook, if the harness sets it,
+// so the harness can model the DR as the hardware does: every read returns
+// the next received byte and every write sends a byte. The hook returns the
+// location of the access. Without a hook the DR is a plain register.
+extern volatile uint8_t* (*_stm8_host_i2c_data)(void);
+#define _STM8_HOST_I2C_DR (*(_stm8_host_i2c_data ? _stm8_host_i2c_data()\
+    : &_stm8_host_registers[0x5216 - STM8_HOST_REGISTERS_START]))
+
+///////////////////////////////////////////////////////////////////////////////
+// The SDCC extensions and the STM8 instructions, which do nothing on the host
+///////////////////////////////////////////////////////////////////////////////
+#define __interrupt(vector)
+#define __critical
+#define nop() {}
+#define rim() {}
+#define sim() {}
+#define wfi() {}
+#define halt() {}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Hooks for modelling the hardware, to be used by the harness. They expand to
+// the register names, so the header of the peripheral must be included.
+///////////////////////////////////////////////////////////////////////////////
+
+// Defines the emulated register file and the hooks. It must be used once by
+// the harness, outside of any method.
+#define stm8HostRegisterFile() \
+volatile uint8_t _stm8_host_registers[STM8_HOST_REGISTERS_SIZE];\
+volatile uint8_t* (*_stm8_host_i2c_data)(void);
+
+// Sets all the registers to zero
+#define stm8HostReset() memset((void*)_stm8_host_registers, 0, STM8_HOST_REGISTERS_SIZE)
+
+// Sets the I2C registers as the hardware does for an event, before the I2C
+// interrupt handler is called
+// Parameters:
+// - sr1, sr2, sr3: The values of the status registers
+// - dr: The value of the data register (the received byte)
+#define stm8HostI2cEvent(sr1, sr2, sr3, dr) do {\
+  REGISTER_I2C_SR1 = sr1;\
+  REGISTER_I2C_SR2 = sr2;\
+  REGISTER_I2C_SR3 = sr3;\
+  REGISTER_I2C_DR = dr;\
+} while(0)
+
+// Returns the byte the I2C interrupt handler wrote for the master
+#define stm8HostI2cSent() REGISTER_I2C_DR
+
+// Sets the input pins of a port, before the port interrupt handler is called
+// Parameters:
+// - port: One of A, B, C, D, E, F
+// - value: The state of all the pins
+#define _stm8HostSetPort(port, value) REGISTER_P##port##_IDR = value
+#define stm8HostSetPort(port, value) _stm8HostSetPort(port, value)
+
+// Sets the TIM4 update flag as an overflow does, before the TIM4 interrupt
+// handler is called
+#define stm8HostTim4Overflow() REGISTER_TIM4_SR |= TIM4_SR_UIF
+
+#endif /* STM8_HOST_H */
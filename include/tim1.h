@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   tim1.h
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#ifndef STM8_TIM1_H
+#define STM8_TIM1_H
+
+#include <stm8.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// TIM1 registers
+///////////////////////////////////////////////////////////////////////////////
+#define REGISTER_TIM1_CR1   REGISTER(0x5250) // Control register 1
+#define REGISTER_TIM1_CR2   REGISTER(0x5251) // Control register 2
+#define REGISTER_TIM1_SMCR  REGISTER(0x5252) // Slave mode control register
+#define REGISTER_TIM1_ETR   REGISTER(0x5253) // External trigger register
+#define REGISTER_TIM1_IER   REGISTER(0x5254) // Interrupt enable register
+#define REGISTER_TIM1_SR1   REGISTER(0x5255) // Status register 1
+#define REGISTER_TIM1_SR2   REGISTER(0x5256) // Status register 2
+#define REGISTER_TIM1_EGR   REGISTER(0x5257) // Event generation register
+#define REGISTER_TIM1_CCMR1 REGISTER(0x5258) // Capture/compare mode register 1
+#define REGISTER_TIM1_CCMR2 REGISTER(0x5259) // Capture/compare mode register 2
+#define REGISTER_TIM1_CCMR3 REGISTER(0x525A) // Capture/compare mode register 3
+#define REGISTER_TIM1_CCMR4 REGISTER(0x525B) // Capture/compare mode register 4
+#define REGISTER_TIM1_CCER1 REGISTER(0x525C) // Capture/compare enable register 1
+#define REGISTER_TIM1_CCER2 REGISTER(0x525D) // Capture/compare enable register 2
+#define REGISTER_TIM1_CNTRH REGISTER(0x525E) // Counter high
+#define REGISTER_TIM1_CNTRL REGISTER(0x525F) // Counter low
+#define REGISTER_TIM1_PSCRH REGISTER(0x5260) // Prescaler register high
+#define REGISTER_TIM1_PSCRL REGISTER(0x5261) // Prescaler register low
+#define REGISTER_TIM1_ARRH  REGISTER(0x5262) // Auto-reload register high
+#define REGISTER_TIM1_ARRL  REGISTER(0x5263) // Auto-reload register low
+#define REGISTER_TIM1_RCR   REGISTER(0x5264) // Repetition counter register
+#define REGISTER_TIM1_CCR1H REGISTER(0x5265) // Capture/compare register 1 high
+#define REGISTER_TIM1_CCR1L REGISTER(0x5266) // Capture/compare register 1 low
+#define REGISTER_TIM1_CCR2H REGISTER(0x5267) // Capture/compare register 2 high
+#define REGISTER_TIM1_CCR2L REGISTER(0x5268) // Capture/compare register 2 low
+#define REGISTER_TIM1_CCR3H REGISTER(0x5269) // Capture/compare register 3 high
+#define REGISTER_TIM1_CCR3L REGISTER(0x526A) // Capture/compare register 3 low
+#define REGISTER_TIM1_CCR4H REGISTER(0x526B) // Capture/compare register 4 high
+#define REGISTER_TIM1_CCR4L REGISTER(0x526C) // Capture/compare register 4 low
+#define REGISTER_TIM1_BKR   REGISTER(0x526D) // Break register
+#define REGISTER_TIM1_DTR   REGISTER(0x526E) // Dead-time register
+#define REGISTER_TIM1_OISR  REGISTER(0x526F) // Output idle state register
+
+///////////////////////////////////////////////////////////////////////////////
+// TIM1 register flags
+///////////////////////////////////////////////////////////////////////////////
+#define TIM1_CR1_CEN         (uint8_t) 0b00000001 // Counter enable
+#define TIM1_IER_CC1IE       (uint8_t) 0b00000010 // Capture/compare 1 interrupt enable
+#define TIM1_IER_UIE         (uint8_t) 0b00000001 // Update interrupt enable
+#define TIM1_SR1_CC2IF       (uint8_t) 0b00000100 // Capture/compare 2 interrupt flag
+#define TIM1_SR1_CC1IF       (uint8_t) 0b00000010 // Capture/compare 1 interrupt flag
+#define TIM1_SR1_UIF         (uint8_t) 0b00000001 // Update interrupt flag
+#define TIM1_EGR_UG          (uint8_t) 0b00000001 // Update generation
+#define TIM1_CCMR_CC_TI      (uint8_t) 0b00000001 // Input capture from the own input
+#define TIM1_CCMR_ICPSC_8    (uint8_t) 0b00001100 // Capture every 8 events
+#define TIM1_CCER1_CC2E      (uint8_t) 0b00010000 // Capture/compare 2 enable
+#define TIM1_CCER1_CC1P      (uint8_t) 0b00000010 // Capture/compare 1 polarity (falling)
+#define TIM1_CCER1_CC1E      (uint8_t) 0b00000001 // Capture/compare 1 enable
+
+#endif /* STM8_TIM1_H */
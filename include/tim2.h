@@ -0,0 +1,284 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   tim2.h
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#ifndef STM8_TIM2_H
+#define STM8_TIM2_H
+
+#include <stm8.h>
+#include <itc.h>
+#include <utils.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// TIM2 registers
+///////////////////////////////////////////////////////////////////////////////
+#define REGISTER_TIM2_CR1   REGISTER(0x5300) // Control register 1
+#define REGISTER_TIM2_IER   REGISTER(0x5303) // Interrupt enable register
+#define REGISTER_TIM2_SR1   REGISTER(0x5304) // Status register 1
+#define REGISTER_TIM2_SR2   REGISTER(0x5305) // Status register 2
+#define REGISTER_TIM2_EGR   REGISTER(0x5306) // Event generation register
+#define REGISTER_TIM2_CCMR1 REGISTER(0x5307) // Capture/compare mode register 1
+#define REGISTER_TIM2_CCMR2 REGISTER(0x5308) // Capture/compare mode register 2
+#define REGISTER_TIM2_CCMR3 REGISTER(0x5309) // Capture/compare mode register 3
+#define REGISTER_TIM2_CCER1 REGISTER(0x530A) // Capture/compare enable register 1
+#define REGISTER_TIM2_CCER2 REGISTER(0x530B) // Capture/compare enable register 2
+#define REGISTER_TIM2_CNTRH REGISTER(0x530C) // Counter high
+#define REGISTER_TIM2_CNTRL REGISTER(0x530D) // Counter low
+#define REGISTER_TIM2_PSCR  REGISTER(0x530E) // Prescaler register
+#define REGISTER_TIM2_ARRH  REGISTER(0x530F) // Auto-reload register high
+#define REGISTER_TIM2_ARRL  REGISTER(0x5310) // Auto-reload register low
+#define REGISTER_TIM2_CCR1H REGISTER(0x5311) // Capture/compare register 1 high
+#define REGISTER_TIM2_CCR1L REGISTER(0x5312) // Capture/compare register 1 low
+#define REGISTER_TIM2_CCR2H REGISTER(0x5313) // Capture/compare register 2 high
+#define REGISTER_TIM2_CCR2L REGISTER(0x5314) // Capture/compare register 2 low
+#define REGISTER_TIM2_CCR3H REGISTER(0x5315) // Capture/compare register 3 high
+#define REGISTER_TIM2_CCR3L REGISTER(0x5316) // Capture/compare register 3 low
+
+///////////////////////////////////////////////////////////////////////////////
+// TIM2 register flags
+///////////////////////////////////////////////////////////////////////////////
+#define TIM2_CR1_ARPE    (uint8_t) 0b10000000 // Auto-reload preload enable
+#define TIM2_CR1_OPM     (uint8_t) 0b00001000 // One-pulse mode
+#define TIM2_CR1_URS     (uint8_t) 0b00000100 // Update request source
+#define TIM2_CR1_UDIS    (uint8_t) 0b00000010 // Update disable
+#define TIM2_CR1_CEN     (uint8_t) 0b00000001 // Counter enable
+#define TIM2_IER_CC3IE   (uint8_t) 0b00001000 // Capture/compare 3 interrupt enable
+#define TIM2_IER_CC2IE   (uint8_t) 0b00000100 // Capture/compare 2 interrupt enable
+#define TIM2_IER_CC1IE   (uint8_t) 0b00000010 // Capture/compare 1 interrupt enable
+#define TIM2_IER_UIE     (uint8_t) 0b00000001 // Update interrupt enable
+#define TIM2_SR1_CC3IF   (uint8_t) 0b00001000 // Capture/compare 3 interrupt flag
+#define TIM2_SR1_CC2IF   (uint8_t) 0b00000100 // Capture/compare 2 interrupt flag
+#define TIM2_SR1_CC1IF   (uint8_t) 0b00000010 // Capture/compare 1 interrupt flag
+#define TIM2_SR1_UIF     (uint8_t) 0b00000001 // Update interrupt flag
+#define TIM2_SR2_CC3OF   (uint8_t) 0b00001000 // Capture/compare 3 overcapture flag
+#define TIM2_SR2_CC2OF   (uint8_t) 0b00000100 // Capture/compare 2 overcapture flag
+#define TIM2_SR2_CC1OF   (uint8_t) 0b00000010 // Capture/compare 1 overcapture flag
+#define TIM2_EGR_UG      (uint8_t) 0b00000001 // Update generation
+#define TIM2_CCER1_CC2P  (uint8_t) 0b00100000 // Capture/compare 2 polarity
+#define TIM2_CCER1_CC2E  (uint8_t) 0b00010000 // Capture/compare 2 enable
+#define TIM2_CCER1_CC1P  (uint8_t) 0b00000010 // Capture/compare 1 polarity
+#define TIM2_CCER1_CC1E  (uint8_t) 0b00000001 // Capture/compare 1 enable
+#define TIM2_CCER2_CC3P  (uint8_t) 0b00000010 // Capture/compare 3 polarity
+#define TIM2_CCER2_CC3E  (uint8_t) 0b00000001 // Capture/compare 3 enable
+
+///////////////////////////////////////////////////////////////////////////////
+// TIM2 prescaler values
+///////////////////////////////////////////////////////////////////////////////
+#define _TIM2_PRESCALER_MASK (uint8_t) 0b00001111
+#define TIM2_PRESCALER_1     (uint8_t) 0b00000000
+#define TIM2_PRESCALER_2     (uint8_t) 0b00000001
+#define TIM2_PRESCALER_4     (uint8_t) 0b00000010
+#define TIM2_PRESCALER_8     (uint8_t) 0b00000011
+#define TIM2_PRESCALER_16    (uint8_t) 0b00000100
+#define TIM2_PRESCALER_32    (uint8_t) 0b00000101
+#define TIM2_PRESCALER_64    (uint8_t) 0b00000110
+#define TIM2_PRESCALER_128   (uint8_t) 0b00000111
+#define TIM2_PRESCALER_256   (uint8_t) 0b00001000
+#define TIM2_PRESCALER_512   (uint8_t) 0b00001001
+#define TIM2_PRESCALER_1024  (uint8_t) 0b00001010
+#define TIM2_PRESCALER_2048  (uint8_t) 0b00001011
+#define TIM2_PRESCALER_4096  (uint8_t) 0b00001100
+#define TIM2_PRESCALER_8192  (uint8_t) 0b00001101
+#define TIM2_PRESCALER_16384 (uint8_t) 0b00001110
+#define TIM2_PRESCALER_32768 (uint8_t) 0b00001111
+
+///////////////////////////////////////////////////////////////////////////////
+// TIM2 input capture filter values (the ICxF bits of the CCMRx registers).
+// The name gives the sampling frequency and the number of consecutive equal
+// samples (N) required for a transition to be validated.
+///////////////////////////////////////////////////////////////////////////////
+#define TIM2_ICF_NONE         (uint8_t) 0b0000
+#define TIM2_ICF_MASTER_N2    (uint8_t) 0b0001
+#define TIM2_ICF_MASTER_N4    (uint8_t) 0b0010
+#define TIM2_ICF_MASTER_N8    (uint8_t) 0b0011
+#define TIM2_ICF_MASTER_2_N6  (uint8_t) 0b0100
+#define TIM2_ICF_MASTER_2_N8  (uint8_t) 0b0101
+#define TIM2_ICF_MASTER_4_N6  (uint8_t) 0b0110
+#define TIM2_ICF_MASTER_4_N8  (uint8_t) 0b0111
+#define TIM2_ICF_MASTER_8_N6  (uint8_t) 0b1000
+#define TIM2_ICF_MASTER_8_N8  (uint8_t) 0b1001
+#define TIM2_ICF_MASTER_16_N5 (uint8_t) 0b1010
+#define TIM2_ICF_MASTER_16_N6 (uint8_t) 0b1011
+#define TIM2_ICF_MASTER_16_N8 (uint8_t) 0b1100
+#define TIM2_ICF_MASTER_32_N5 (uint8_t) 0b1101
+#define TIM2_ICF_MASTER_32_N6 (uint8_t) 0b1110
+#define TIM2_ICF_MASTER_32_N8 (uint8_t) 0b1111
+
+///////////////////////////////////////////////////////////////////////////////
+// TIM2 input capture edge polarities
+///////////////////////////////////////////////////////////////////////////////
+#define TIM2_CAPTURE_RISING  0 // Capture on the rising edge
+#define TIM2_CAPTURE_FALLING 1 // Capture on the falling edge
+
+///////////////////////////////////////////////////////////////////////////////
+// Helper values for accessing the registers of each capture channel
+///////////////////////////////////////////////////////////////////////////////
+#define _TIM2_CCMR_IC_TI     (uint8_t) 0b00000001 // CCxS: input, mapped on TIx
+#define _TIM2_CCMR_ICF_SHIFT 4
+#define _TIM2_1_CCMR  REGISTER_TIM2_CCMR1
+#define _TIM2_2_CCMR  REGISTER_TIM2_CCMR2
+#define _TIM2_3_CCMR  REGISTER_TIM2_CCMR3
+#define _TIM2_1_CCER  REGISTER_TIM2_CCER1
+#define _TIM2_2_CCER  REGISTER_TIM2_CCER1
+#define _TIM2_3_CCER  REGISTER_TIM2_CCER2
+#define _TIM2_1_CCE   TIM2_CCER1_CC1E
+#define _TIM2_2_CCE   TIM2_CCER1_CC2E
+#define _TIM2_3_CCE   TIM2_CCER2_CC3E
+#define _TIM2_1_CCP   TIM2_CCER1_CC1P
+#define _TIM2_2_CCP   TIM2_CCER1_CC2P
+#define _TIM2_3_CCP   TIM2_CCER2_CC3P
+#define _TIM2_1_CCIE  TIM2_IER_CC1IE
+#define _TIM2_2_CCIE  TIM2_IER_CC2IE
+#define _TIM2_3_CCIE  TIM2_IER_CC3IE
+#define _TIM2_1_CCIF  TIM2_SR1_CC1IF
+#define _TIM2_2_CCIF  TIM2_SR1_CC2IF
+#define _TIM2_3_CCIF  TIM2_SR1_CC3IF
+#define _TIM2_1_CCRH  REGISTER_TIM2_CCR1H
+#define _TIM2_2_CCRH  REGISTER_TIM2_CCR2H
+#define _TIM2_3_CCRH  REGISTER_TIM2_CCR3H
+#define _TIM2_1_CCRL  REGISTER_TIM2_CCR1L
+#define _TIM2_2_CCRL  REGISTER_TIM2_CCR2L
+#define _TIM2_3_CCRL  REGISTER_TIM2_CCR3L
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Macros for using the TIM2 by the user
+///////////////////////////////////////////////////////////////////////////////
+
+// Sets the TIM2 prescaler. The counter clock is f_master / 2^value.
+// Parameters:
+// - value: One of the TIM2_PRESCALER_***
+#define _tim2SetPrescaler(value) REGISTER_TIM2_PSCR = value
+#define tim2SetPrescaler(value) _tim2SetPrescaler(value)
+
+// Sets the TIM2 auto-reload value. The high byte must be written first.
+// Parameters:
+// - value: A uint16_t with the value where overflow will happen
+#define _tim2SetPeriod(value) do {\
+  REGISTER_TIM2_ARRH = (uint8_t)((uint16_t)(value) >> 8);\
+  REGISTER_TIM2_ARRL = (uint8_t)(value);\
+} while(0)
+#define tim2SetPeriod(value) _tim2SetPeriod(value)
+
+// Reads the TIM2 counter. The high byte must be read first, so the low byte
+// is latched and the value is consistent.
+// Parameters:
+// - value: A uint16_t variable where the counter is stored
+#define _tim2ReadCounter(value) do {\
+  value = (uint16_t)REGISTER_TIM2_CNTRH << 8;\
+  value |= REGISTER_TIM2_CNTRL;\
+} while(0)
+#define tim2ReadCounter(value) _tim2ReadCounter(value)
+
+// Clears the update interrupt flag. The flags are cleared by writing 0 and
+// writing 1 has no effect, so the register is written directly. A
+// read-modify-write would also clear a capture flag which sets in between.
+#define tim2ClearUpdateInterruptFlag() REGISTER_TIM2_SR1 = (uint8_t)~TIM2_SR1_UIF
+
+// Enables the update interrupt
+#define tim2EnableInterrupt() do {\
+  tim2ClearUpdateInterruptFlag();\
+  registerSet(REGISTER_TIM2_IER, TIM2_IER_UIE);\
+} while(0)
+
+// Starts the TIM2 timer. The prescaler is loaded with an update event first,
+// because otherwise it is only applied at the first overflow.
+#define tim2Start() do {\
+  registerSet(REGISTER_TIM2_EGR, TIM2_EGR_UG);\
+  tim2ClearUpdateInterruptFlag();\
+  registerSet(REGISTER_TIM2_CR1, TIM2_CR1_CEN);\
+} while(0)
+
+// Configures a TIM2 channel for input capture on its own input pin (TI1 on
+// D4, TI2 on D3, TI3 on A3) and enables the capture. The capture is disabled
+// while the channel is configured, as the CCMR can only be written then.
+// Parameters:
+// - channel: The capture channel, one of 1, 2 or 3
+// - filter: One of the TIM2_ICF_***
+// - polarity: One of TIM2_CAPTURE_RISING or TIM2_CAPTURE_FALLING
+#define _tim2SetupCapture(channel, filter, polarity) do {\
+  _TIM2_##channel##_CCER &= ~_TIM2_##channel##_CCE;\
+  _TIM2_##channel##_CCMR = (uint8_t)((filter) << _TIM2_CCMR_ICF_SHIFT) | _TIM2_CCMR_IC_TI;\
+  if (polarity) {\
+    registerSet(_TIM2_##channel##_CCER, _TIM2_##channel##_CCP);\
+  } else {\
+    _TIM2_##channel##_CCER &= ~_TIM2_##channel##_CCP;\
+  }\
+  registerSet(_TIM2_##channel##_CCER, _TIM2_##channel##_CCE);\
+} while(0)
+#define tim2SetupCapture(channel, filter, polarity) _tim2SetupCapture(channel, filter, polarity)
+
+// Enables the capture interrupt of a TIM2 channel
+// Parameters:
+// - channel: The capture channel, one of 1, 2 or 3
+#define _tim2EnableCaptureInterrupt(channel) do {\
+  REGISTER_TIM2_SR1 = (uint8_t)~_TIM2_##channel##_CCIF;\
+  registerSet(REGISTER_TIM2_IER, _TIM2_##channel##_CCIE);\
+} while(0)
+#define tim2EnableCaptureInterrupt(channel) _tim2EnableCaptureInterrupt(channel)
+
+// Reads the last captured value of a TIM2 channel. The high byte is read
+// first, which blocks new captures until the low byte is read, so the two
+// bytes always belong to the same capture. Reading the low byte also clears
+// the capture interrupt flag.
+// Parameters:
+// - channel: The capture channel, one of 1, 2 or 3
+// - value: A uint16_t variable where the captured value is stored
+#define _tim2ReadCapture(channel, value) do {\
+  value = (uint16_t)_TIM2_##channel##_CCRH << 8;\
+  value |= _TIM2_##channel##_CCRL;\
+} while(0)
+#define tim2ReadCapture(channel, value) _tim2ReadCapture(channel, value)
+
+
+//
+// This macro implements the TIM2 capture/compare interrupt handler. For every
+// channel which has captured an edge it reads the 16-bit timestamp (high byte
+// first, so it is never torn between two captures) and passes it to the
+// given function, which has the following signature:
+// - First parameter (uint8_t channel):
+//      The capture channel, one of 1, 2 or 3
+// - Second parameter (uint16_t timestamp):
+//      The value of the TIM2 counter when the edge was detected
+//
+// If an edge was missed because the previous capture was not read in time, the
+// overcapture flag is cleared and the new timestamp is still delivered.
+//
+#define tim2CaptureInterruptHandler(handleCapture) \
+void _tim2CaptureInterruptHandler() __interrupt(ITC_IRQ_TIM2_CPT_CMP) {\
+  uint8_t sr1 = REGISTER_TIM2_SR1;\
+  uint16_t timestamp;\
+  if (sr1 & TIM2_SR1_CC1IF) {\
+    tim2ReadCapture(1, timestamp);\
+    handleCapture(1, timestamp);\
+  }\
+  if (sr1 & TIM2_SR1_CC2IF) {\
+    tim2ReadCapture(2, timestamp);\
+    handleCapture(2, timestamp);\
+  }\
+  if (sr1 & TIM2_SR1_CC3IF) {\
+    tim2ReadCapture(3, timestamp);\
+    handleCapture(3, timestamp);\
+  }\
+  REGISTER_TIM2_SR2 = 0;\
+}
+
+#endif /* STM8_TIM2_H */
@@ -31,13 +31,13 @@
 ///////////////////////////////////////////////////////////////////////////////
 // TIM4 registers
 ///////////////////////////////////////////////////////////////////////////////
-#define REGISTER_TIM4_CR1  REGISTER 0x5340 // Control register 1
-#define REGISTER_TIM4_IER  REGISTER 0x5343 // Interrupt enable register
-#define REGISTER_TIM4_SR   REGISTER 0x5344 // Status register
-#define REGISTER_TIM4_EGR  REGISTER 0x5345 // Even generation register
-#define REGISTER_TIM4_CNTR REGISTER 0x5346 // Counter
-#define REGISTER_TIM4_PSCR REGISTER 0x5347 // Prescaler register
-#define REGISTER_TIM4_ARR  REGISTER 0x5348 // Auto-reoad register
+#define REGISTER_TIM4_CR1  REGISTER(0x5340) // Control register 1
+#define REGISTER_TIM4_IER  REGISTER(0x5343) // Interrupt enable register
+#define REGISTER_TIM4_SR   REGISTER(0x5344) // Status register
+#define REGISTER_TIM4_EGR  REGISTER(0x5345) // Even generation register
+#define REGISTER_TIM4_CNTR REGISTER(0x5346) // Counter
+#define REGISTER_TIM4_PSCR REGISTER(0x5347) // Prescaler register
+#define REGISTER_TIM4_ARR  REGISTER(0x5348) // Auto-reoad register
 
 ///////////////////////////////////////////////////////////////////////////////
 // TIM4 register flags
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   timer.h
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#ifndef STM8_TIMER_H
+#define STM8_TIMER_H
+
+#include <stdbool.h>
+#include <stm8.h>
+#include <itc.h>
+#include <tim4.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Software timers, driven by the TIM4. The active timers are kept in a list
+// sorted by their expiry, where every timer keeps only the ms after the expiry
+// of the previous one. This way the TIM4 interrupt visits only the timers which
+// expire, no matter how many are active.
+//
+// In tickless mode the TIM4 period is set to the time until the first expiry,
+// so the interrupt occurs only when a timer expires, and the TIM4 is stopped
+// when there is no active timer. The TIM4 has an 8-bit counter, so its period
+// cannot be longer than 2 ms. Longer waits take one interrupt every 2 ms.
+///////////////////////////////////////////////////////////////////////////////
+
+// Value for the tickless parameter of the timerInitialize()
+#define TIMER_TICKLESS true
+
+// The TIM4 ticks in a ms and the longest TIM4 period (in ms)
+#define _TIMER_TICKS_PER_MS 125
+#define _TIMER_MAX_INTERVAL 2
+
+// The prescaler which gives 125 TIM4 ticks per ms, for the f_master in MHz
+#define _TIMER_PRESCALER(frequency) (\
+  (frequency) == 1 ? TIM4_PRESCALER_8 :\
+  (frequency) == 2 ? TIM4_PRESCALER_16 :\
+  (frequency) == 4 ? TIM4_PRESCALER_32 :\
+  (frequency) == 8 ? TIM4_PRESCALER_64 :\
+  (frequency) == 16 ? TIM4_PRESCALER_128 : 0xFF)
+
+// A software timer. Its members are managed by the timer methods.
+typedef struct _Timer {
+  struct _Timer* next; // The next active timer
+  uint16_t delta; // The ms between the expiry of the previous active timer and this one
+  uint16_t period; // The period (in ms), or 0 for a one-shot timer
+  bool active; // If the timer is in the list of the active timers
+  void (*callback)(void*); // Called with the context when the timer expires
+  void* context; // The parameter of the callback
+} Timer;
+
+// The state of the software timers
+typedef struct {
+  Timer* head; // The active timer which expires first
+  uint8_t interval; // The current TIM4 period (in ms)
+  bool tickless; // If the TIM4 period follows the first expiry
+} _TimerState;
+
+extern _TimerState _timer_state;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal methods, not to be used by the user
+///////////////////////////////////////////////////////////////////////////////
+
+// Inserts a timer in the active list, after the timers which expire at the same
+// time. The delay is counted from the start of the current TIM4 period.
+void _timerInsert(_TimerState* state, Timer* timer, uint16_t delay);
+
+// Removes an active timer from the list, giving its time to the next one
+void _timerRemove(_TimerState* state, Timer* timer);
+
+// Sets the TIM4 period to the first expiry in tickless mode, or stops the TIM4
+// if there are no active timers. It must be called when a TIM4 period starts.
+void _timerSchedule(_TimerState* state);
+
+void _timerInitialize(_TimerState* state, uint8_t prescaler, bool tickless);
+
+void _timerStart(_TimerState* state, Timer* timer, uint16_t delay, uint16_t period);
+
+void _timerStop(_TimerState* state, Timer* timer);
+
+void _timer(_TimerState* state);
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Macros and methods for using the software timers, to be used by the user
+///////////////////////////////////////////////////////////////////////////////
+
+// Initializes the TIM4 for the software timers. The TIM4 cannot be used for
+// anything else.
+// Parameters:
+// - frequency: The frequency f_master (in MHz), one of 1, 2, 4, 8 or 16
+// - tickless: TIMER_TICKLESS for interrupts only when timers expire, or false
+//             for an interrupt every ms
+#define timerInitialize(frequency, tickless) do {\
+  _Static_assert(_TIMER_PRESCALER(frequency) != 0xFF, "The timers need an f_master of 1, 2, 4, 8 or 16 MHz");\
+  _timerInitialize(&_timer_state, _TIMER_PRESCALER(frequency), tickless);\
+} while(0)
+
+// Sets the method called when a timer expires. It must be called before the
+// timer is started for the first time.
+// Parameters:
+// - timer: A pointer to the Timer
+// - onExpiry: The method to call, which gets the data as parameter. It is
+//             called from the TIM4 interrupt.
+// - data: The parameter of the method (or 0)
+#define timerSetup(timer, onExpiry, data) do {\
+  (timer)->active = false;\
+  (timer)->callback = onExpiry;\
+  (timer)->context = data;\
+} while(0)
+
+// Starts (or restarts) a timer. It can be called from the timer callbacks too.
+// Parameters:
+// - timer: A pointer to the Timer
+// - delay: The minimum ms until the first expiry (1-65000). The timers count
+//          whole ms of the TIM4, so the expiry can be up to 1 ms later.
+// - period: The ms between the next expiries, or 0 for a one-shot timer
+#define timerStart(timer, delay, period) _timerStart(&_timer_state, timer, delay, period)
+
+// Stops a timer, so its callback is not called. Stopping an inactive timer has
+// no effect.
+// Parameters:
+// - timer: A pointer to the Timer
+#define timerStop(timer) _timerStop(&_timer_state, timer)
+
+// Returns true if the timer is started and has not expired yet (or if it is
+// periodic)
+#define timerIsActive(timer) ((timer)->active)
+
+// Setups the TIM4 interruption for the software timers. It must be used once,
+// outside of any method.
+#define timerInterruptHandler() \
+_TimerState _timer_state;\
+void _timerInterruptHandler() __interrupt(ITC_IRQ_TIM4_UPD_OVF) {\
+  _timer(&_timer_state);\
+}
+
+#endif /* STM8_TIMER_H */
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * File:   uart.h
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#ifndef STM8_UART_H
+#define STM8_UART_H
+
+#include <stdbool.h>
+#include <stm8.h>
+#include <utils.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// UART1 registers
+///////////////////////////////////////////////////////////////////////////////
+#define REGISTER_UART1_SR   REGISTER(0x5230) // Status register
+#define REGISTER_UART1_DR   REGISTER(0x5231) // Data register
+#define REGISTER_UART1_BRR1 REGISTER(0x5232) // Baud rate register 1
+#define REGISTER_UART1_BRR2 REGISTER(0x5233) // Baud rate register 2
+#define REGISTER_UART1_CR1  REGISTER(0x5234) // Control register 1
+#define REGISTER_UART1_CR2  REGISTER(0x5235) // Control register 2
+#define REGISTER_UART1_CR3  REGISTER(0x5236) // Control register 3
+#define REGISTER_UART1_CR4  REGISTER(0x5237) // Control register 4
+#define REGISTER_UART1_CR5  REGISTER(0x5238) // Control register 5
+#define REGISTER_UART1_GTR  REGISTER(0x5239) // Guard time register
+#define REGISTER_UART1_PSCR REGISTER(0x523A) // Prescaler register
+
+///////////////////////////////////////////////////////////////////////////////
+// UART1 register flags
+///////////////////////////////////////////////////////////////////////////////
+#define UART1_SR_TXE    (uint8_t) 0b10000000 // Transmit data register empty
+#define UART1_SR_TC     (uint8_t) 0b01000000 // Transmission complete
+#define UART1_SR_RXNE   (uint8_t) 0b00100000 // Read data register not empty
+#define UART1_SR_IDLE   (uint8_t) 0b00010000 // IDLE line detected
+#define UART1_SR_OR     (uint8_t) 0b00001000 // Overrun error
+#define UART1_SR_NF     (uint8_t) 0b00000100 // Noise flag
+#define UART1_SR_FE     (uint8_t) 0b00000010 // Framing error
+#define UART1_SR_PE     (uint8_t) 0b00000001 // Parity error
+#define UART1_CR1_M     (uint8_t) 0b00010000 // Word length (9 bits)
+#define UART1_CR1_PCEN  (uint8_t) 0b00000100 // Parity control enable
+#define UART1_CR1_PS    (uint8_t) 0b00000010 // Parity selection (odd)
+#define UART1_CR2_TIEN  (uint8_t) 0b10000000 // Transmitter interrupt enable
+#define UART1_CR2_TCIEN (uint8_t) 0b01000000 // Transmission complete interrupt enable
+#define UART1_CR2_RIEN  (uint8_t) 0b00100000 // Receiver interrupt enable
+#define UART1_CR2_ILIEN (uint8_t) 0b00010000 // IDLE line interrupt enable
+#define UART1_CR2_TEN   (uint8_t) 0b00001000 // Transmitter enable
+#define UART1_CR2_REN   (uint8_t) 0b00000100 // Receiver enable
+#define _UART1_CR3_STOP_MASK (uint8_t) 0b00110000 // Number of stop bits
+
+///////////////////////////////////////////////////////////////////////////////
+// The sizes of the ring buffers. They must be powers of two, up to 128, and
+// they are set in the Makefile.
+///////////////////////////////////////////////////////////////////////////////
+#ifdef UART1_RX_BUFFER_SIZE
+#error "UART1_RX_BUFFER_SIZE must be set in the Makefile, as the library is compiled with it"
+#endif
+#ifdef _STM8_UART1_RX_BUFFER_SIZE
+#define UART1_RX_BUFFER_SIZE _STM8_UART1_RX_BUFFER_SIZE
+#else
+#define UART1_RX_BUFFER_SIZE 16
+#endif
+#ifdef UART1_TX_BUFFER_SIZE
+#error "UART1_TX_BUFFER_SIZE must be set in the Makefile, as the library is compiled with it"
+#endif
+#ifdef _STM8_UART1_TX_BUFFER_SIZE
+#define UART1_TX_BUFFER_SIZE _STM8_UART1_TX_BUFFER_SIZE
+#else
+#define UART1_TX_BUFFER_SIZE 32
+#endif
+#if (UART1_RX_BUFFER_SIZE) & ((UART1_RX_BUFFER_SIZE) - 1) || (UART1_RX_BUFFER_SIZE) < 1 || (UART1_RX_BUFFER_SIZE) > 128
+#error "UART1_RX_BUFFER_SIZE must be a power of two, up to 128"
+#endif
+#if (UART1_TX_BUFFER_SIZE) & ((UART1_TX_BUFFER_SIZE) - 1) || (UART1_TX_BUFFER_SIZE) < 1 || (UART1_TX_BUFFER_SIZE) > 128
+#error "UART1_TX_BUFFER_SIZE must be a power of two, up to 128"
+#endif
+#define _UART1_RX_MASK (uint8_t)(UART1_RX_BUFFER_SIZE - 1)
+#define _UART1_TX_MASK (uint8_t)(UART1_TX_BUFFER_SIZE - 1)
+
+// The state of the UART1 driver. The indices run freely and are masked when
+// the buffers are accessed, so the number of used bytes is tail - head. Each
+// index is written only by one side (the ISR or the main code), so no
+// interrupts need to be disabled.
+typedef struct {
+  uint8_t rx[UART1_RX_BUFFER_SIZE]; // The received bytes
+  volatile uint8_t rx_head; // The next byte to be read by the user
+  volatile uint8_t rx_tail; // The next free place for a received byte
+  volatile uint8_t rx_dropped; // The received bytes lost (buffer full or overrun)
+  uint8_t tx[UART1_TX_BUFFER_SIZE]; // The bytes to be transmitted
+  volatile uint8_t tx_head; // The next byte to be transmitted
+  volatile uint8_t tx_tail; // The next free place for a byte to transmit
+} _Uart1State;
+
+// The UART1 state, which is defined by the uart1InterruptHandlers() macro
+extern _Uart1State _uart1_state;
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Macros and methods for handling the UART1, to be used by the user
+///////////////////////////////////////////////////////////////////////////////
+
+// Initializes the UART1 with the given baud rate divider, 8 data bits, no
+// parity and 1 stop bit. Use the uart1Initialize() macro instead, which
+// computes the divider.
+// Parameters:
+// - divider: The f_master / baud rate (at least 16)
+void _uart1Initialize(uint16_t divider);
+
+// Initializes the UART1 (TX on D5, RX on D6) with 8 data bits, no parity and
+// 1 stop bit. The divider is computed at compile time, so the parameters must
+// be constants, and baud rates which are too high for the f_master fail to
+// compile.
+// Parameters:
+// - frequency: The frequency f_master which is fed to the peripheral (in MHz)
+// - baudrate: The baud rate in bit/s
+#define uart1Initialize(frequency, baudrate) do {\
+  _Static_assert(((uint32_t)(frequency) * 1000000UL) / (baudrate) >= 16,\
+                 "The baud rate is too high for the f_master");\
+  _Static_assert(((uint32_t)(frequency) * 1000000UL) / (baudrate) <= 0xFFFF,\
+                 "The baud rate is too low for the f_master");\
+  _uart1Initialize((uint16_t)(((uint32_t)(frequency) * 1000000UL\
+                               + (baudrate) / 2) / (baudrate)));\
+} while(0)
+
+// Queues bytes to be transmitted. The method never waits, it queues as many
+// bytes as fit in the buffer.
+// Parameters:
+// - data: The bytes to transmit
+// - size: The number of bytes to transmit
+// Returns:
+//    The number of bytes which were queued
+uint8_t _uart1Put(_Uart1State* state, const uint8_t* data, uint8_t size);
+#define uart1Put(data, size) _uart1Put(&_uart1_state, data, size)
+
+// Gets received bytes. The method never waits, it returns only the bytes which
+// are already received.
+// Parameters:
+// - data: The buffer where the bytes are copied
+// - size: The maximum number of bytes to get
+// Returns:
+//    The number of bytes copied in the buffer
+uint8_t _uart1Get(_Uart1State* state, uint8_t* data, uint8_t size);
+#define uart1Get(data, size) _uart1Get(&_uart1_state, data, size)
+
+// Returns the number of bytes which can be queued for transmission
+#define uart1TxFree() (uint8_t)(UART1_TX_BUFFER_SIZE - (uint8_t)(_uart1_state.tx_tail - _uart1_state.tx_head))
+
+// Returns the number of received bytes waiting to be read
+#define uart1RxAvailable() (uint8_t)(_uart1_state.rx_tail - _uart1_state.rx_head)
+
+// Returns true when all the queued bytes are completely transmitted
+#define uart1TxDone() (_uart1_state.tx_tail == _uart1_state.tx_head && (REGISTER_UART1_SR & UART1_SR_TC))
+
+// Handles the transmit data register empty event
+void _uart1Transmit(_Uart1State* state);
+
+// Handles the received data event
+void _uart1Receive(_Uart1State* state);
+
+//
+// This macro implements the UART1 transmit and receive interrupt handlers,
+// which move the bytes between the peripheral and the ring buffers. It must be
+// called once, in the file with the main method, for the uart1Put() and
+// uart1Get() to work.
+//
+// For an example of how to use this macro see the src/examples/uart_example.c
+//
+#define uart1InterruptHandlers() \
+_Uart1State _uart1_state;\
+void _uart1TransmitInterruptHandler() __interrupt(ITC_IRQ_UART1_TX) {\
+  _uart1Transmit(&_uart1_state);\
+}\
+void _uart1ReceiveInterruptHandler() __interrupt(ITC_IRQ_UART1_RX) {\
+  _uart1Receive(&_uart1_state);\
+}
+
+#endif /* STM8_UART_H */
@@ -27,19 +27,25 @@
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// Aliases for addressing the registers in the memory
+// Aliases for addressing the registers in the memory. In the host build (see
+// stm8_host.h) the registers are kept in an emulated register file instead.
 ///////////////////////////////////////////////////////////////////////////////
-#define REGISTER    *(volatile unsigned char *)
-#define REGISTER_RO *(volatile const unsigned char *)
+#ifdef STM8_HOST
+#define REGISTER(address)    _stm8_host_registers[(address) - STM8_HOST_REGISTERS_START]
+#define REGISTER_RO(address) REGISTER(address)
+#else
+#define REGISTER(address)    (*(volatile unsigned char *)(address))
+#define REGISTER_RO(address) (*(volatile const unsigned char *)(address))
+#endif
 
 ///////////////////////////////////////////////////////////////////////////////
 // Macros for setting and un-setting bits of a register
 ///////////////////////////////////////////////////////////////////////////////
-#define _registerSet(reg, bits) reg |= bits
+#define _registerSet(reg, bits) reg |= (bits)
 #define registerSet(reg, bits) _registerSet(reg, bits)
-#define _registerUnset(reg, bits) reg &= !bits
+#define _registerUnset(reg, bits) reg &= ~(bits)
 #define registerUnset(reg, bits) _registerUnset(reg, bits)
-#define _registerInvert(reg, bits) reg ^= bits
+#define _registerInvert(reg, bits) reg ^= (bits)
 #define registerInvert(reg, bits) _registerInvert(reg, bits)
 
 #endif /* STM8_UTILS_H */
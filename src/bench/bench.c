@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   bench.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include "bench.h"
+
+uint16_t _bench_overhead;
+
+uint16_t _benchTicks() {
+  // The high byte must be read first, which latches the low one
+  uint16_t ticks = (uint16_t)REGISTER_TIM1_CNTRH << 8;
+  return ticks | REGISTER_TIM1_CNTRL;
+}
+
+void _benchPut(char c) {
+  while (!(REGISTER_UART1_SR & UART1_SR_TXE));
+  REGISTER_UART1_DR = c;
+}
+
+void benchReport(const char* name, uint16_t cycles) {
+  char digits[5];
+  uint8_t count = 0;
+  
+  while (*name) {
+    _benchPut(*name++);
+  }
+  _benchPut(' ');
+  do {
+    digits[count++] = '0' + cycles % 10;
+    cycles /= 10;
+  } while (cycles);
+  while (count) {
+    _benchPut(digits[--count]);
+  }
+  _benchPut('\n');
+}
+
+void benchInitialize() {
+  uint16_t start;
+  
+  clkSetHsiDivider(1);
+  uart1Initialize(16, 115200);
+  REGISTER_TIM1_CR1 = TIM1_CR1_CEN;
+  
+  start = _benchTicks();
+  _bench_overhead = _benchTicks() - start;
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   bench.h
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+///////////////////////////////////////////////////////////////////////////////
+// Helpers for the benchmarks, which are run by the "make bench" in the sstm8
+// simulator. The cycles are counted with the TIM1, which runs at the f_master
+// like the CPU, and the results are sent over the UART1 (polled, so no
+// interrupt disturbs the measurements) as lines of the form "<name> <cycles>".
+// The benchmark ends with a break instruction, which stops the simulator. The
+// methods are in the src/bench/bench.c, which is linked with every benchmark.
+//
+// Every benchmark must also use the uart1InterruptHandlers() macro, for the
+// state of the UART1 driver.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef STM8_BENCH_H
+#define STM8_BENCH_H
+
+#include <stm8.h>
+#include <clk.h>
+#include <tim1.h>
+#include <uart.h>
+
+// The TIM1 ticks spent by the measurement itself
+extern uint16_t _bench_overhead;
+
+// Returns the TIM1 counter, which counts the cycles
+uint16_t _benchTicks();
+
+// Sends a line with the name of a measurement and its cycles
+void benchReport(const char* name, uint16_t cycles);
+
+// Sets the f_master to 16 MHz and starts the TIM1 and the UART1. It must be
+// called before any measurement, with the interrupts disabled.
+void benchInitialize();
+
+// Measures the cycles of a piece of code, which must take less than 65536
+// cycles, and reports them
+// Parameters:
+// - name: The name of the measurement, without spaces
+// - code: The code to measure
+#define benchMeasure(name, code) do {\
+  uint16_t _bench_start = _benchTicks();\
+  code;\
+  benchReport(name, _benchTicks() - _bench_start - _bench_overhead);\
+} while(0)
+
+// Waits for the last report to be sent and stops the simulator
+#define benchEnd() do {\
+  while (!(REGISTER_UART1_SR & UART1_SR_TC));\
+  __asm__("break\n");\
+  while (1);\
+} while(0)
+
+#endif /* STM8_BENCH_H */
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   i2c_bench.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+/*
+ * Measures the initialization of the I2C and the work the register map slave
+ * does for every I2C event, for a write of a 2-byte register followed by a
+ * read of it and of the next register. The simulator does not drive the I2C
+ * bus and its status flags are set only by the hardware, so the memory slave
+ * methods the handler calls for every event are measured directly. The event
+ * dispatch of the _i2cMemorySlave() (a few tests of the status registers) is
+ * not included.
+ */
+
+#include <clk.h>
+#include <i2c.h>
+#include <uart.h>
+#include "bench.h"
+
+uint16_t value_1 = 0x1234;
+uint32_t value_2 = 0x12345678;
+
+const RegmapEntry registers[] = {
+  regmapRegister(0x01, value_1, REGMAP_READ_WRITE),
+  regmapRegister(0x02, value_2, REGMAP_READ_ONLY)
+};
+
+i2cRegisterMapSlaveInterruptHandler(registers, 4)
+
+uart1InterruptHandlers()
+
+int main() {
+  
+  _MemorySlaveState* state = &_i2c_memory_slave_state.memory;
+  
+  benchInitialize();
+  
+  benchMeasure("i2cInitialize", i2cInitializeMode(0x55, 16, FAST));
+  
+  // The master writes the register 0x01. The RXNE of the first byte selects
+  // the ID, the next ones write the buffer and the STOPF commits it.
+  benchMeasure("i2c_rx_id", _memorySlaveSelect(state, 0x01));
+  benchMeasure("i2c_rx_data", _memorySlaveWrite(state, 0x56));
+  benchMeasure("i2c_rx_data_last", _memorySlaveWrite(state, 0x78));
+  benchMeasure("i2c_stop_commit", _memorySlaveCommit(state));
+  
+  // The master selects the register 0x01 and reads it and the next one. The
+  // ADDR of the read takes the snapshot and every TXE reads a byte.
+  benchMeasure("i2c_rx_id_select", _memorySlaveSelect(state, 0x01));
+  benchMeasure("i2c_addr_read", _memorySlaveSnapshot(state));
+  benchMeasure("i2c_tx_data", _memorySlaveRead(state));
+  benchMeasure("i2c_tx_data_last", _memorySlaveRead(state));
+  benchMeasure("i2c_tx_data_next_register", _memorySlaveRead(state));
+  
+  // An unmapped ID
+  benchMeasure("i2c_rx_id_unmapped", _memorySlaveSelect(state, 0x7F));
+  
+  benchEnd();
+}
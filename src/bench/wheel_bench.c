@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   wheel_bench.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+/*
+ * Measures the interrupt work of the WheelSpeedReader program, which is
+ * included with its main renamed, so its methods can be called directly.
+ */
+
+#define main wheelSpeedReaderMain
+#include "../programs/WheelSpeedReader.c"
+#undef main
+
+#include <uart.h>
+#include "bench.h"
+
+uart1InterruptHandlers()
+
+int main() {
+  
+  benchInitialize();
+  
+  timerInitialize(16, TIMER_TICKLESS);
+  startWheel(&wheel_1);
+  startWheel(&wheel_2);
+  startWheel(&wheel_3);
+  startWheel(&wheel_4);
+  
+  // The edge counting takes the same time for any number of edges
+  setupPinCounters();
+  port_in_state = gpioReadPort(PORT_IN);
+  benchMeasure("countEdges_no_edge", countEdges());
+  port_in_state ^= gpioPinMask(PIN_IN_1);
+  benchMeasure("countEdges_1_edge", countEdges());
+  port_in_state ^= gpioPinMask(PIN_IN_1) | gpioPinMask(PIN_IN_2) | gpioPinMask(PIN_IN_3) | gpioPinMask(PIN_IN_4);
+  benchMeasure("countEdges_4_edges", countEdges());
+  
+  // The speed measurement of a wheel, as called by its timer
+  wheel_1.count = 1234;
+  benchMeasure("measureSpeed", measureSpeed(&wheel_1));
+  wheel_1.period = 50;
+  benchMeasure("measureSpeed_new_period", measureSpeed(&wheel_1));
+  
+  // The TIM4 interrupt, when no timer expires and when all the wheels measure
+  benchMeasure("timer_no_expiry", _timer(&_timer_state));
+  timerStart(&wheel_1.timer, 1, 50);
+  timerStart(&wheel_2.timer, 1, 100);
+  timerStart(&wheel_3.timer, 1, 100);
+  timerStart(&wheel_4.timer, 1, 100);
+  benchMeasure("timer_4_expiries", _timer(&_timer_state));
+  
+  benchEnd();
+}
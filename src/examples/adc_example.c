@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This example demonstrates how to use the ADC with the adc.h. The ADC scans
+ * continuously the channels AIN2 (C4), AIN3 (D2) and AIN4 (D3), with 2 bits of
+ * oversampling, so the results are 12-bit. A single interrupt delivers the
+ * results of all the channels of a scan. The LED on D4 shows if the AIN2 is
+ * above the half of the AIN3, and the analog watchdog turns on the LED on D5
+ * when the AIN4 goes above 3/4 of the supply, without waiting for the results.
+ * 
+ * To test the example connect potentiometers to the analog inputs and LEDs
+ * (with a 330 ohm resistor) to the D4 and D5 pins.
+ */
+
+#include <clk.h>
+#include <gpio.h>
+#include <itc.h>
+#include <adc.h>
+
+// The watchdog function, called from the interrupt when a watched channel is
+// out of the window
+void overThreshold(uint16_t channels) {
+  if (channels & (1 << 4)) {
+    gpioWriteHigh(D, 5);
+  }
+}
+
+int main() {
+  
+  uint8_t sequence = 0;
+  
+  // First we set the f_master to 16 MHz
+  clkSetHsiDivider(1);
+  
+  // The LEDs
+  gpioSetAsOutput(D, 4);
+  gpioSetAsPushPull(D, 4);
+  gpioSetAsOutput(D, 5);
+  gpioSetAsPushPull(D, 5);
+  
+  // Initialize the ADC. The first parameter is the f_master (in MHz), the
+  // second is the last channel of the scan, the third the mode and the last
+  // the number of oversampling bits.
+  adcInitialize(16, 4, ADC_CONTINUOUS | ADC_SCAN, 2);
+  
+  // Watch the AIN4 for values above 3/4 of the supply (the thresholds are
+  // 10-bit)
+  adcEnableWatchdog(1 << 4, 0, 768);
+  
+  // We must enable the interrupts
+  enableInterrupts();
+  
+  // Start the conversions, which run until the adcStop()
+  adcStart();
+  
+  while (1) {
+    // Sleep until the next interrupt and check if there are new results
+    waitForInterrupt();
+    if (adcSequence() == sequence) {
+      continue;
+    }
+    sequence = adcSequence();
+    if (adcRead(2) > adcRead(3) / 2) {
+      gpioWriteHigh(D, 4);
+    } else {
+      gpioWriteLow(D, 4);
+    }
+  }
+  
+}
+
+// The macro generates the ADC interrupt handler. We do not need a function for
+// the results, because we check them with the adcSequence().
+adcInterruptHandler(0, overThreshold)
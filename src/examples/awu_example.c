@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * This example demonstrates how to use the active-halt with the auto-wakeup
+ * of the awu.h. The LED on D4 flashes for a moment every second and the rest
+ * of the time the MCU is halted, with all the clocks except the LSI stopped,
+ * so it consumes a few microamps instead of milliamps. The AWU timebase is
+ * calibrated by measuring the LSI against the HSI.
+ * 
+ * To test the example connect a LED (with a 330 ohm resistor) to the D4 pin.
+ * Note that the debugger cannot be used while the MCU is halted.
+ */
+
+#include <clk.h>
+#include <gpio.h>
+#include <itc.h>
+#include <awu.h>
+
+int main() {
+  
+  uint16_t i;
+  uint32_t lsi;
+  
+  // First we set the f_master to 16 MHz
+  clkSetHsiDivider(1);
+  
+  // The LED
+  gpioSetAsOutput(D, 4);
+  gpioSetAsPushPull(D, 4);
+  
+  // Measure the LSI, so the interval is accurate, and wake up every 1000 ms. If
+  // the measurement fails we fall back to the nominal frequency.
+  lsi = awuMeasureLsi(16);
+  awuInitialize(lsi ? lsi : AWU_LSI_FREQUENCY, 1000);
+  
+  // We must enable the interrupts, for the AWU to wake up the MCU
+  enableInterrupts();
+  
+  while (1) {
+    // Flash the LED
+    gpioWriteHigh(D, 4);
+    for (i = 0; i < 10000; ++i);
+    gpioWriteLow(D, 4);
+    
+    // Stop everything until the AWU interrupt
+    halt();
+  }
+  
+}
+
+// The macro generates the AWU interrupt handler. Nothing needs to be done in
+// the interrupt, the main loop continues after the halt().
+awuInterruptHandler(0)
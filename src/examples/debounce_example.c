@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * This example demonstrates how to debounce a switch. It is the same circuit as
+ * the external_interrupt_example: a LED is connected to one pin (D4) and a
+ * switch to another pin (C5). Instead of using the external interrupts, which
+ * are triggered more than once when the switch bounces, the port C is sampled
+ * every 5 ms by a software timer. A change of the switch is accepted only when
+ * it lasts for 4 samples, so every press inverts the LED exactly once.
+ * 
+ * Materials:
+ * - A LED
+ * - A 330 ohm resistor to be connected with the LED (to properly calculate
+ *   the value see here: http://www.evilmadscientist.com/2012/resistors-for-leds)
+ * - A switch
+ * 
+ * Connections:
+ * - Connect the cathode of te LED (short leg) to the ground (GND)
+ * - Connect the anode of the the LED (long leg) to the one side of the 330 ohm
+ *   resistor
+ * - Connect the other side of the 330 ohm resistor to the D4 pin
+ * - Connect the one side of the switch to the C5 pin
+ * - Connect the other side of the switch to the ground
+ */
+
+#include <clk.h>
+#include <gpio.h>
+#include <timer.h>
+#include <debounce.h>
+
+#define LED_PORT D
+#define LED_PIN 4
+#define SWITCH_PORT C
+#define SWITCH_PIN 5
+
+// The debouncer of the port where the switch is connected
+Debouncer switch_debouncer;
+
+// This method is called by the debouncer with the masks of the pins which went
+// high and low. The switch connects the pin to the ground, so a press is a
+// falling edge.
+void onSwitchEdges(uint8_t rising, uint8_t falling) {
+  // The releases are ignored
+  (void) rising;
+  
+  if (falling & gpioPinMask(SWITCH_PIN)) {
+    gpioInvert(LED_PORT, LED_PIN);
+  }
+}
+
+// The debouncer samples the port from the software timers, which use the TIM4
+timerInterruptHandler()
+
+int main() {
+  
+  // Set the f_master to 16 MHz
+  clkSetHsiDivider(1);
+  
+  // We set the GPIO where the LED is connected as a push-pull output
+  gpioSetAsOutput(LED_PORT, LED_PIN);
+  gpioSetAsPushPull(LED_PORT, LED_PIN);
+  
+  // We set the GPIO where the switch is connected as a pull-up input, without
+  // the external interrupt
+  gpioSetAsInput(SWITCH_PORT, SWITCH_PIN);
+  gpioSetAsPullUp(SWITCH_PORT, SWITCH_PIN);
+  
+  // Initialize the software timers and start sampling the port every 5 ms. A
+  // change must last 4 samples (20 ms), which is longer than the bounces.
+  timerInitialize(16, TIMER_TICKLESS);
+  debounceStart(&switch_debouncer, SWITCH_PORT, 4, 5, onSwitchEdges);
+  
+  enableInterrupts();
+  
+  // The LED is inverted by the interrupts, so we just wait for them
+  while (1) {
+    waitForInterrupt();
+  }
+}
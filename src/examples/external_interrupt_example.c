@@ -24,7 +24,8 @@
  * 
  * Note: Because of switch bounce the interrupt might be triggered more than
  * once each time the switch changes state. This can be fixed with a capacitor,
- * but this is omitted here for simplicity.
+ * or by sampling the switch with a timer instead of using the interrupts, as
+ * in the debounce_example.
  * 
  * Materials:
  * - A LED
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * This example demonstrates an I2C slave which spends its idle time in halt,
+ * where it consumes only a few microamps, and wakes up when the master
+ * addresses it. It is initialized with the I2C_WAKEUP_FROM_HALT option and its
+ * main loop goes back to halt with the i2cHaltWhenIdle() after every
+ * transaction. The clock is stretched while the MCU wakes up, so the master
+ * sees a normal (slightly slower) transaction.
+ * 
+ * The slave has the address 0x55 and exposes two registers. The register 0x01
+ * controls the LED on D4 and the register 0x02 counts the transactions (2
+ * bytes, MSB first). A Raspberry Pi can be used for testing:
+ * 
+ *   i2cset -y 1 0x55 0x01 0x01     # Turns the LED on
+ *   i2cget -y 1 0x55 0x02 w        # Returns the number of transactions
+ */
+
+#include <clk.h>
+#include <gpio.h>
+#include <itc.h>
+#include <i2c.h>
+
+// The registers
+uint8_t led = 0;
+uint16_t transactions = 0;
+
+const RegmapEntry registers[] = {
+  regmapRegister(0x01, led, REGMAP_READ_WRITE),
+  regmapRegister(0x02, transactions, REGMAP_READ_ONLY)
+};
+
+int main() {
+  
+  // First we set the f_master to 16 MHz
+  clkSetHsiDivider(1);
+  
+  // The LED
+  gpioSetAsOutput(D, 4);
+  gpioSetAsPushPull(D, 4);
+  
+  // We initialize the I2C with the wakeup from halt
+  i2cInitializeOptions(0x55, 16, STANDARD, I2C_WAKEUP_FROM_HALT);
+  
+  // We must enable the interrupts
+  enableInterrupts();
+  
+  while (1) {
+    // Halt until the master addresses us and, during the transaction, wait for
+    // the I2C interrupts
+    i2cHaltWhenIdle();
+    
+    // Every time the bus becomes idle a transaction is finished, so we apply
+    // what the master wrote
+    if (!(REGISTER_I2C_SR3 & I2C_SR3_BUSY)) {
+      ++transactions;
+      if (led) {
+        gpioWriteHigh(D, 4);
+      } else {
+        gpioWriteLow(D, 4);
+      }
+    }
+  }
+  
+}
+
+// The macro generates the I2C interrupt handler, which also clears the wakeup
+// flag
+i2cRegisterMapSlaveInterruptHandler(registers, 2)
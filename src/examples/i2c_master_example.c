@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This example demonstrates how to use the I2C peripheral in master mode, using
+ * the i2cMasterInterruptHandler() macro. It reads the WHO_AM_I register (0x75)
+ * of an MPU-6050 IMU (address 0x68) with a write-then-read transaction and
+ * turns on a LED if the IMU answered with its own address.
+ * 
+ * The transaction is queued with the i2cMasterSubmit() and it is executed by
+ * the I2C interrupts, so the CPU sleeps while waiting for it to finish.
+ * 
+ * Materials:
+ * - An MPU-6050 breakout board (with pull-up resistors on SDA and SCL)
+ * - A LED
+ * - A 330 ohm resistor to be connected with the LED
+ * 
+ * Connections:
+ * - Connect the SDA (B5) and SCL (B4) pins to the SDA and SCL of the IMU
+ * - Connect the cathode of te LED (short leg) to the ground (GND)
+ * - Connect the anode of the the LED (long leg) to the one side of the 330 ohm
+ *   resistor
+ * - Connect the other side of the 330 ohm resistor to the D4 pin
+ */
+
+#include <clk.h>
+#include <gpio.h>
+#include <i2c_master.h>
+#include <itc.h>
+
+#define LED_PORT D
+#define LED_PIN 4
+
+// The address of the IMU and the register we read
+#define IMU_ADDRESS 0x68
+#define IMU_WHO_AM_I 0x75
+
+int main() {
+  
+  // The byte we write (the register) and the byte we read (its value)
+  uint8_t reg = IMU_WHO_AM_I;
+  uint8_t value = 0;
+  
+  // The transaction writes the register and then reads its value
+  I2cTransaction transaction;
+  transaction.address = IMU_ADDRESS;
+  transaction.write_data = &reg;
+  transaction.write_size = 1;
+  transaction.read_data = &value;
+  transaction.read_size = 1;
+  
+  // First we set the f_master to 16 MHz
+  clkSetHsiDivider(1);
+  
+  // Set the LED pin as a push-pull output
+  gpioSetAsOutput(LED_PORT, LED_PIN);
+  gpioSetAsPushPull(LED_PORT, LED_PIN);
+  
+  // We initialize the I2C in fast mode (400 kbit/s). The address is not used
+  // in master mode.
+  i2cInitializeMode(0x01, 16, FAST);
+  
+  // We must enable the interrupts
+  enableInterrupts();
+  
+  // Queue the transaction. It starts immediately, as the queue is empty.
+  i2cMasterSubmit(&transaction);
+  
+  // Sleep until the transaction is finished
+  while (transaction.status == I2C_TRANSACTION_PENDING) {
+    waitForInterrupt();
+  }
+  
+  // Turn on the LED if the IMU answered
+  if (transaction.status == I2C_TRANSACTION_DONE && value == IMU_ADDRESS) {
+    gpioWriteHigh(LED_PORT, LED_PIN);
+  }
+  
+  while (1) {
+    waitForInterrupt();
+  }
+  
+}
+
+// The macro generates the I2C interrupt handler which executes the queued
+// transactions
+i2cMasterInterruptHandler()
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This example demonstrates how to use the interrupt driven SPI master of the
+ * spi_master.h. It drives two chained 74HC595 shift registers, which show a
+ * 16 bit counter on 16 LEDs. The bytes are shifted out by the SPI interrupt
+ * and the completion function latches them to the outputs of the shift
+ * registers.
+ * 
+ * To test the example connect the SCK (C5) to the SHCP pins, the MOSI (C6) to
+ * the DS pin of the first 74HC595 and the A3 to the STCP pins. The Q7S pin of
+ * the first 74HC595 goes to the DS pin of the second one.
+ */
+
+#include <clk.h>
+#include <gpio.h>
+#include <itc.h>
+#include <spi_master.h>
+
+// The function called from the SPI interrupt when the bytes are shifted out. A
+// rising edge of the STCP copies them to the outputs.
+void latch() {
+  gpioWriteHigh(A, 3);
+  gpioWriteLow(A, 3);
+}
+
+int main() {
+  
+  uint16_t counter = 0;
+  uint8_t data[2];
+  uint16_t i;
+  
+  // First we set the f_master to 16 MHz
+  clkSetHsiDivider(1);
+  
+  // The A3 drives the STCP of the shift registers
+  gpioSetAsOutput(A, 3);
+  gpioSetAsPushPull(A, 3);
+  gpioWriteLow(A, 3);
+  
+  // Initialize the SPI. The first parameter is the f_master (in MHz), the
+  // second the maximum SCK frequency (in kHz) and the third the SPI mode. The
+  // 74HC595 samples on the rising edge of the clock, so we use the mode 0.
+  spiInitializeMaster(16, 1000, SPI_MODE_0);
+  
+  // We must enable the interrupts
+  enableInterrupts();
+  
+  while (1) {
+    // The byte for the second shift register goes first
+    data[0] = (uint8_t)(counter >> 8);
+    data[1] = (uint8_t)counter;
+    spiTransfer(data, 0, 2);
+    
+    // The data buffer must not change until the transfer is finished
+    while (spiIsBusy());
+    ++counter;
+    
+    // Wait a bit, so the counting is visible
+    for (i = 0; i < 10000; ++i);
+  }
+  
+}
+
+// The macro generates the SPI interrupt handler, which calls the latch()
+// function at the end of every transfer
+spiMasterInterruptHandler(latch)
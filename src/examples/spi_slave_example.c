@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This example demonstrates how to expose local memory locations via SPI,
+ * using the spiRegisterMapSlaveInterruptHandler() macro. It is the same adder
+ * as the i2c_adder_example.c: two single byte variables with IDs 0x01 and 0x02
+ * and a 2 byte read-only variable with ID 0x03, which the main program keeps
+ * updated with their sum. The same register map could be served via I2C, with
+ * the i2cRegisterMapSlaveInterruptHandler() macro.
+ * 
+ * A Raspberry Pi can be used for testing. Connect the SCLK, MOSI, MISO and CE0
+ * pins to the C5, C6, C7 and A3 pins and run in python:
+ * 
+ *   import spidev
+ *   spi = spidev.SpiDev()
+ *   spi.open(0, 0)
+ *   spi.max_speed_hz = 100000
+ *   spi.xfer2([0x02, 0x01, 0x82, 0xA3])  # Write var1 and var2
+ *   spi.xfer2([0x03, 0x01, 0, 0, 0, 0])  # Returns [.., .., .., 0x82, 0xA3, 0x01]
+ *   spi.xfer2([0x03, 0x03, 0, 0, 0])     # Returns [.., .., .., 0x01, 0x25]
+ * 
+ * The first byte of a frame is the command (0x02 for write and 0x03 for read)
+ * and the second the ID. For reads the data start at the fourth byte. Note
+ * that the STM8 stores the MSB first, so the result is 0x0125.
+ */
+
+#include <clk.h>
+#include <itc.h>
+#include <regmap.h>
+#include <spi_slave.h>
+
+// The three variables
+uint8_t var1 = 0;
+uint8_t var2 = 0;
+uint16_t var3 = 0;
+
+// The register map, which exposes the variables
+const RegmapEntry registers[] = {
+  regmapRegister(0x01, var1, REGMAP_READ_WRITE),
+  regmapRegister(0x02, var2, REGMAP_READ_WRITE),
+  regmapRegister(0x03, var3, REGMAP_READ_ONLY)
+};
+
+int main() {
+  
+  // First we set the f_master to 16 MHz
+  clkSetHsiDivider(1);
+  
+  // We initialize the SPI as slave. The Raspberry Pi uses the SPI mode 0 by
+  // default.
+  spiInitializeSlave(SPI_MODE_0);
+  
+  // We must enable the interrupts
+  enableInterrupts();
+  
+  // Start an infinite loop
+  while(1) {
+    // Inside the loop we constantly add the variables
+    var3 = var1 + var2;
+  }
+  
+}
+
+// Finally, we call the spiRegisterMapSlaveInterruptHandler macro. This will
+// generate the functions which handle the SPI and the Port A interrupts. The
+// second parameter is the size of the biggest register.
+spiRegisterMapSlaveInterruptHandler(registers, 2)
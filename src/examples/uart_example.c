@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * This example demonstrates how to use the UART1 with the interrupt driven ring
+ * buffers of the uart.h. It runs at 115200 baud and echoes back every received
+ * byte. The transmission and the reception are done by the interrupts, so the
+ * main loop never waits for the UART and sleeps when there is nothing to do.
+ * 
+ * To test the example connect the TX (D5) and RX (D6) pins to the RX and TX
+ * pins of a 3.3V USB-serial adapter and open a terminal, for example with
+ * "picocom -b 115200 /dev/ttyUSB0". Everything typed is sent back.
+ */
+
+#include <clk.h>
+#include <itc.h>
+#include <uart.h>
+
+int main() {
+  
+  // The bytes received but not sent back yet
+  uint8_t buffer[8];
+  uint8_t size = 0;
+  uint8_t sent;
+  uint8_t i;
+  
+  // First we set the f_master to 16 MHz
+  clkSetHsiDivider(1);
+  
+  // Initialize the UART1. The first parameter is the f_master (in MHz) and the
+  // second the baud rate.
+  uart1Initialize(16, 115200);
+  
+  // We must enable the interrupts
+  enableInterrupts();
+  
+  while (1) {
+    // Get as many bytes as fit in the buffer and send back as many as fit in
+    // the transmit buffer. Neither of the calls waits.
+    size += uart1Get(buffer + size, sizeof(buffer) - size);
+    sent = uart1Put(buffer, size);
+    
+    // Keep the bytes which did not fit for the next time
+    for (i = sent; i < size; ++i) {
+      buffer[i - sent] = buffer[i];
+    }
+    size -= sent;
+    
+    // Sleep until the next byte is received or transmitted
+    waitForInterrupt();
+  }
+  
+}
+
+// The macro generates the UART1 interrupt handlers which move the bytes
+// between the peripheral and the buffers
+uart1InterruptHandlers()
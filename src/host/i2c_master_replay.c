@@ -0,0 +1,472 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   i2c_master_replay.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+/*
+ * Host harness (see stm8_host.h) which replays I2C master transactions against
+ * a model of the peripheral and of a memory slave. Every round queues one to
+ * I2C_MASTER_QUEUE_SIZE random transactions (writes, reads, write-then-reads,
+ * probes and transactions to a missing slave), so they follow each other with
+ * repeated STARTs, and runs the bus until they are finished. It fails if the
+ * sequence seen on the bus, the statuses, the read bytes or the slave memory
+ * differ from the expected ones.
+ *
+ * The model keeps the flags set until the hardware would clear them, so the
+ * interrupt fires again for the flags the handler leaves set (like the BTF
+ * after a START request), before the bus makes its next step.
+ * Transactions are queued only while the master is idle.
+ *
+ * Usage: i2c_master_replay [rounds] (default 100000)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <i2c_master.h>
+
+i2cMasterInterruptHandler()
+
+stm8HostRegisterFile()
+
+// The address of the slave and an address nobody answers
+#define SLAVE_ADDRESS 0x50
+#define MISSING_ADDRESS 0x51
+
+// The most bus steps a round can take
+#define MAX_STEPS 1000
+
+// The times the interrupt is served while it is pending, before the bus moves
+#define MAX_REENTRIES 2
+
+// The codes of the bus log. The data bytes are logged as they are.
+#define LOG_START   0x100
+#define LOG_STOP    0x200
+#define LOG_READ    0x300 // | the bytes, the last one not acknowledged
+#define LOG_READ_NO_NACK 0x400 // | the bytes, all of them acknowledged
+#define LOG_ACK     0x500 // | the address byte
+#define LOG_NACK    0x600 // | the address byte
+#define LOG_SIZE 128
+
+// A xorshift generator, so every replay is the same
+uint32_t random_state = 2463534242UL;
+
+uint32_t nextRandom() {
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return random_state;
+}
+
+// The errors of the current round
+unsigned long round_errors;
+
+void error(const char* message) {
+  if (round_errors == 0) {
+    fprintf(stderr, "%s\n", message);
+  }
+  ++round_errors;
+}
+
+// The sequence seen on the bus
+uint16_t bus_log[LOG_SIZE];
+uint8_t bus_log_size;
+
+void logBus(uint16_t code) {
+  if (bus_log_size < LOG_SIZE) {
+    bus_log[bus_log_size++] = code;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// The slave, a memory where the first written byte of a transaction selects
+// the location the next bytes are written to or read from
+///////////////////////////////////////////////////////////////////////////////
+struct {
+  uint8_t memory[256];
+  uint8_t pointer; // The next location
+  bool first; // If the next written byte is the location
+  uint8_t sent; // The bytes sent in the current read
+} slave;
+
+///////////////////////////////////////////////////////////////////////////////
+// The peripheral
+///////////////////////////////////////////////////////////////////////////////
+struct {
+  uint8_t sr1;
+  uint8_t sr2;
+  bool master; // If the peripheral generated a START and no STOP yet
+  bool addressed; // If the slave acknowledged the address
+  bool transmitter; // If the master writes after the address
+  bool address_pending; // If the address is written and not sent yet
+  uint8_t address; // The address byte
+  bool dr_full; // If the DR has a byte to send or a received byte
+  uint8_t dr;
+  bool shift_full; // If the shift register has a byte
+  uint8_t shift;
+  bool slave_sending; // If the slave sends the next byte (the last was ACKed)
+  bool ack_next; // The ACK of the next received byte, when the POS is set
+  uint8_t read; // The byte returned by the last read of the DR
+} bus;
+
+// The hook of the I2C data register. After the SB the master writes the
+// address, in transmitter mode it writes the data and in receiver mode it reads
+// them.
+volatile uint8_t* accessData() {
+  if (bus.sr1 & I2C_SR1_SB) {
+    bus.sr1 &= ~I2C_SR1_SB;
+    bus.address_pending = true;
+    return &bus.address;
+  }
+  if (bus.transmitter) {
+    if (bus.dr_full) {
+      error("The DR was written before it was empty");
+    }
+    bus.dr_full = true;
+    bus.sr1 &= ~(I2C_SR1_TXE | I2C_SR1_BTF);
+    return &bus.dr;
+  }
+  if (!bus.dr_full) {
+    error("The DR was read without a received byte");
+  }
+  bus.read = bus.dr;
+  // The byte waiting in the shift register moves to the DR
+  if (bus.shift_full) {
+    bus.dr = bus.shift;
+    bus.shift_full = false;
+    bus.sr1 = (bus.sr1 & ~I2C_SR1_BTF) | I2C_SR1_RXNE;
+  } else {
+    bus.dr_full = false;
+    bus.sr1 &= ~(I2C_SR1_RXNE | I2C_SR1_BTF);
+  }
+  return &bus.read;
+}
+
+// Returns true if the I2C interrupt is requested
+bool interruptPending() {
+  uint8_t itr = REGISTER_I2C_ITR;
+  return ((itr & I2C_ITR_ITEVTEN) && (bus.sr1 & (I2C_SR1_SB | I2C_SR1_ADDR | I2C_SR1_BTF)))
+      || ((itr & I2C_ITR_ITEVTEN) && (itr & I2C_ITR_ITBUFEN) && (bus.sr1 & (I2C_SR1_TXE | I2C_SR1_RXNE)))
+      || ((itr & I2C_ITR_ITERREN) && (bus.sr2 & (I2C_SR2_AF | I2C_SR2_ARLO | I2C_SR2_BERR)));
+}
+
+// Calls the interrupt handler with the flags of the model
+void interrupt() {
+  bool addr = bus.sr1 & I2C_SR1_ADDR;
+  
+  REGISTER_I2C_SR1 = bus.sr1;
+  REGISTER_I2C_SR2 = bus.sr2;
+  REGISTER_I2C_SR3 = (bus.master ? I2C_SR3_MSL | I2C_SR3_BUSY : 0)
+                   | (bus.transmitter ? I2C_SR3_TRA : 0);
+  _i2cMasterInterruptHandler();
+  // The SR2 flags are cleared by writing 0 and every ADDR event reads the SR3
+  bus.sr2 &= REGISTER_I2C_SR2;
+  if (addr) {
+    bus.sr1 &= ~I2C_SR1_ADDR;
+    if (bus.transmitter) {
+      bus.sr1 |= I2C_SR1_TXE;
+    }
+  }
+}
+
+// Ends the read of the slave, when the master stops receiving
+void endRead(bool nack) {
+  if (bus.slave_sending) {
+    logBus((nack ? LOG_READ : LOG_READ_NO_NACK) | slave.sent);
+    bus.slave_sending = false;
+  }
+}
+
+// Generates the requested START or STOP, if any
+void generateCondition() {
+  uint8_t cr2 = REGISTER_I2C_CR2;
+  
+  if (!(cr2 & (I2C_CR2_START | I2C_CR2_STOP))) {
+    return;
+  }
+  endRead(false);
+  bus.addressed = false;
+  bus.sr1 = 0;
+  bus.dr_full = false;
+  bus.shift_full = false;
+  if (cr2 & I2C_CR2_START) {
+    REGISTER_I2C_CR2 = cr2 & ~I2C_CR2_START;
+    bus.master = true;
+    bus.sr1 = I2C_SR1_SB;
+    logBus(LOG_START);
+  } else {
+    REGISTER_I2C_CR2 = cr2 & ~I2C_CR2_STOP;
+    bus.master = false;
+    logBus(LOG_STOP);
+  }
+}
+
+// Moves the bus by one byte or condition
+void stepBus() {
+  uint8_t cr2 = REGISTER_I2C_CR2;
+  bool ack;
+  
+  // The SCL is stretched until the handler serves the SB and the ADDR
+  if (bus.sr1 & (I2C_SR1_SB | I2C_SR1_ADDR)) {
+    return;
+  }
+  
+  if (bus.address_pending) {
+    bus.address_pending = false;
+    if ((bus.address >> 1) != SLAVE_ADDRESS) {
+      logBus(LOG_NACK | bus.address);
+      bus.sr2 |= I2C_SR2_AF;
+      return;
+    }
+    logBus(LOG_ACK | bus.address);
+    bus.addressed = true;
+    bus.transmitter = !(bus.address & 1);
+    bus.slave_sending = !bus.transmitter;
+    bus.ack_next = cr2 & I2C_CR2_ACK;
+    slave.first = true;
+    slave.sent = 0;
+    bus.sr1 = I2C_SR1_ADDR;
+    return;
+  }
+  
+  if (bus.addressed && bus.transmitter) {
+    if (bus.shift_full) {
+      // The byte in the shift register reaches the slave
+      logBus(bus.shift);
+      if (slave.first) {
+        slave.pointer = bus.shift;
+        slave.first = false;
+      } else {
+        slave.memory[slave.pointer++] = bus.shift;
+      }
+      bus.shift_full = false;
+      if (!bus.dr_full) {
+        bus.sr1 |= I2C_SR1_BTF;
+      }
+    }
+    if (bus.dr_full) {
+      bus.shift = bus.dr;
+      bus.shift_full = true;
+      bus.dr_full = false;
+      bus.sr1 |= I2C_SR1_TXE;
+      return;
+    }
+  }
+  
+  if (bus.addressed && !bus.transmitter) {
+    if (bus.shift_full && !bus.dr_full) {
+      bus.dr = bus.shift;
+      bus.dr_full = true;
+      bus.shift_full = false;
+      bus.sr1 = (bus.sr1 & ~I2C_SR1_BTF) | I2C_SR1_RXNE;
+      return;
+    }
+    if (bus.slave_sending && !bus.shift_full) {
+      // The slave sends the next byte. With the POS the ACK applies to the
+      // byte after the current one.
+      bus.shift = slave.memory[slave.pointer++];
+      ++slave.sent;
+      ack = (cr2 & I2C_CR2_POS) ? bus.ack_next : (cr2 & I2C_CR2_ACK);
+      bus.ack_next = cr2 & I2C_CR2_ACK;
+      if (!ack) {
+        endRead(true);
+      }
+      if (bus.dr_full) {
+        bus.shift_full = true;
+        bus.sr1 |= I2C_SR1_BTF;
+      } else {
+        bus.dr = bus.shift;
+        bus.dr_full = true;
+        bus.sr1 |= I2C_SR1_RXNE;
+      }
+      return;
+    }
+  }
+  
+  generateCondition();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// The replay
+///////////////////////////////////////////////////////////////////////////////
+
+// A queued transaction with its buffers and the expected read bytes
+typedef struct {
+  I2cTransaction transaction;
+  uint8_t write_data[4];
+  uint8_t read_data[8];
+  uint8_t expected[8];
+  uint8_t expected_status;
+} Replay;
+
+// The memory and the pointer the slave should have
+uint8_t expected_memory[256];
+uint8_t expected_pointer;
+
+// The expected bus log
+uint16_t expected_log[LOG_SIZE];
+uint8_t expected_log_size;
+
+void expectBus(uint16_t code) {
+  if (expected_log_size < LOG_SIZE) {
+    expected_log[expected_log_size++] = code;
+  }
+}
+
+// Fills a random transaction and the expected bus sequence, slave memory and
+// read bytes
+void randomTransaction(Replay* replay) {
+  I2cTransaction* transaction = &replay->transaction;
+  uint8_t address = (nextRandom() % 8) ? SLAVE_ADDRESS : MISSING_ADDRESS;
+  uint8_t i;
+  
+  transaction->address = address;
+  transaction->write_data = replay->write_data;
+  transaction->write_size = nextRandom() % 4;
+  transaction->read_data = replay->read_data;
+  transaction->read_size = nextRandom() % 7;
+  for (i = 0; i < transaction->write_size; ++i) {
+    replay->write_data[i] = (uint8_t)nextRandom();
+  }
+  memset(replay->read_data, 0, sizeof(replay->read_data));
+  replay->expected_status = I2C_TRANSACTION_DONE;
+  
+  expectBus(LOG_START);
+  if (transaction->write_size > 0 || transaction->read_size == 0) {
+    if (address != SLAVE_ADDRESS) {
+      expectBus(LOG_NACK | (uint8_t)(address << 1));
+      replay->expected_status = I2C_TRANSACTION_ERROR;
+      return;
+    }
+    expectBus(LOG_ACK | (uint8_t)(address << 1));
+    for (i = 0; i < transaction->write_size; ++i) {
+      expectBus(replay->write_data[i]);
+      if (i == 0) {
+        expected_pointer = replay->write_data[i];
+      } else {
+        expected_memory[expected_pointer++] = replay->write_data[i];
+      }
+    }
+    if (transaction->read_size > 0) {
+      expectBus(LOG_START);
+    }
+  }
+  if (transaction->read_size > 0) {
+    if (address != SLAVE_ADDRESS) {
+      expectBus(LOG_NACK | (uint8_t)(address << 1 | 1));
+      replay->expected_status = I2C_TRANSACTION_ERROR;
+      return;
+    }
+    expectBus(LOG_ACK | (uint8_t)(address << 1 | 1));
+    for (i = 0; i < transaction->read_size; ++i) {
+      replay->expected[i] = expected_memory[expected_pointer++];
+    }
+    expectBus(LOG_READ | transaction->read_size);
+  }
+}
+
+int main(int argc, char** argv) {
+  
+  unsigned long rounds = (argc > 1) ? strtoul(argv[1], 0, 10) : 100000;
+  unsigned long errors = 0;
+  unsigned long transactions = 0;
+  unsigned long round;
+  Replay replays[I2C_MASTER_QUEUE_SIZE];
+  uint8_t count;
+  uint8_t i;
+  uint16_t location;
+  int steps;
+  int reentries;
+  clock_t start;
+  double seconds;
+  
+  stm8HostReset();
+  _stm8_host_i2c_data = accessData;
+  i2cInitializeMode(0x01, 16, FAST);
+  for (location = 0; location < 256; ++location) {
+    slave.memory[location] = expected_memory[location] = (uint8_t)nextRandom();
+  }
+  
+  start = clock();
+  for (round = 0; round < rounds; ++round) {
+    round_errors = 0;
+    bus_log_size = 0;
+    expected_log_size = 0;
+    
+    // Queue the transactions while the master is idle
+    count = 1 + nextRandom() % I2C_MASTER_QUEUE_SIZE;
+    for (i = 0; i < count; ++i) {
+      randomTransaction(&replays[i]);
+    }
+    expectBus(LOG_STOP);
+    for (i = 0; i < count; ++i) {
+      if (!i2cMasterSubmit(&replays[i].transaction)) {
+        error("A transaction was not queued");
+      }
+    }
+    transactions += count;
+    
+    // Run the bus until the master is idle and the STOP is generated
+    for (steps = 0; steps < MAX_STEPS; ++steps) {
+      for (reentries = 0; reentries < MAX_REENTRIES && interruptPending(); ++reentries) {
+        interrupt();
+      }
+      stepBus();
+      if (!_i2c_master_state.busy && !bus.master && !interruptPending()) {
+        break;
+      }
+    }
+    if (steps == MAX_STEPS) {
+      error("The transactions did not finish");
+    }
+    
+    if (bus_log_size != expected_log_size
+        || memcmp(bus_log, expected_log, bus_log_size * sizeof(bus_log[0]))) {
+      error("The bus sequence differs from the expected one");
+    }
+    for (i = 0; i < count; ++i) {
+      if (replays[i].transaction.status != replays[i].expected_status) {
+        error("A transaction has the wrong status");
+      }
+      if (replays[i].expected_status == I2C_TRANSACTION_DONE
+          && memcmp(replays[i].read_data, replays[i].expected, replays[i].transaction.read_size)) {
+        error("A transaction read the wrong bytes");
+      }
+    }
+    if (memcmp(slave.memory, expected_memory, sizeof(expected_memory))) {
+      error("The slave memory differs from the written bytes");
+      memcpy(expected_memory, slave.memory, sizeof(expected_memory));
+    }
+    
+    if (round_errors) {
+      if (errors < 10) {
+        fprintf(stderr, "Round %lu: %u transactions failed\n", round, count);
+      }
+      ++errors;
+    }
+  }
+  seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+  
+  printf("%lu transactions in %.2f s (%.0f transactions/s), %lu errors\n",
+         transactions, seconds, seconds > 0 ? transactions / seconds : 0., errors);
+  return errors ? 1 : 0;
+}
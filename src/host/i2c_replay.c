@@ -0,0 +1,254 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   i2c_replay.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+/*
+ * Host harness (see stm8_host.h) which replays I2C transactions to a register
+ * map slave. It first replays the special cases of the register map protocol:
+ * bursts over consecutive registers, writes to a read only register, accesses
+ * of unmapped IDs and a value which changes while it is read. Then every round
+ * writes random bytes to a random register and reads them back, and fails if
+ * the bytes read or the variable differ from the written ones. It prints the
+ * throughput of the slave state machine, so it can also be run under a
+ * profiler. The I2C master is replayed by the i2c_master_replay.
+ * 
+ * Usage: i2c_replay [rounds] (default 1000000)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <i2c.h>
+
+// The registers. The ID 0x04 is not mapped.
+uint8_t value_1;
+uint16_t value_2;
+uint32_t value_3;
+uint16_t constant = 0xA55A;
+
+const RegmapEntry registers[] = {
+  regmapRegister(0x01, value_1, REGMAP_READ_WRITE),
+  regmapRegister(0x02, value_2, REGMAP_READ_WRITE),
+  regmapRegister(0x03, value_3, REGMAP_READ_WRITE),
+  regmapRegister(0x05, constant, REGMAP_READ_ONLY)
+};
+
+// The registers written by the random rounds
+#define WRITABLE_REGISTERS 3
+
+i2cRegisterMapSlaveInterruptHandler(registers, 4)
+
+stm8HostRegisterFile()
+
+// A xorshift generator, so every replay is the same
+uint32_t random_state = 2463534242UL;
+
+uint32_t nextRandom() {
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return random_state;
+}
+
+// Plays an I2C event and calls the interrupt handler
+void playEvent(uint8_t sr1, uint8_t sr2, uint8_t sr3, uint8_t dr) {
+  stm8HostI2cEvent(sr1, sr2, sr3, dr);
+  _i2cMemorySlaveInterruptHandler();
+}
+
+// Plays a transaction where the master writes bytes to a register
+void writeRegister(uint8_t id, const uint8_t* data, uint8_t size) {
+  uint8_t i;
+  
+  playEvent(I2C_SR1_ADDR, 0, 0, 0);
+  playEvent(I2C_SR1_RXNE, 0, 0, id);
+  for (i = 0; i < size; ++i) {
+    playEvent(I2C_SR1_RXNE, 0, 0, data[i]);
+  }
+  playEvent(I2C_SR1_STOPF, 0, 0, 0);
+}
+
+// Plays the start of a transaction where the master selects a register and,
+// after a repeated start, reads from it
+void beginRead(uint8_t id) {
+  playEvent(I2C_SR1_ADDR, 0, 0, 0);
+  playEvent(I2C_SR1_RXNE, 0, 0, id);
+  playEvent(I2C_SR1_ADDR, 0, I2C_SR3_TRA, 0);
+}
+
+// Plays the transmission of the next byte of a read and returns it
+uint8_t readByte() {
+  playEvent(I2C_SR1_TXE, 0, I2C_SR3_TRA, 0);
+  return stm8HostI2cSent();
+}
+
+// Plays the NACK and the STOP which end a read
+void endRead() {
+  playEvent(0, I2C_SR2_AF, 0, 0);
+  playEvent(I2C_SR1_STOPF, 0, 0, 0);
+}
+
+// Plays a transaction where the master reads bytes from a register
+void readRegister(uint8_t id, uint8_t* data, uint8_t size) {
+  uint8_t i;
+  
+  beginRead(id);
+  for (i = 0; i < size; ++i) {
+    data[i] = readByte();
+  }
+  endRead();
+}
+
+// Reports a failed case and returns 1, to be added to the errors
+unsigned long fail(const char* message) {
+  fprintf(stderr, "%s\n", message);
+  return 1;
+}
+
+// Replays the special cases of the register map protocol and returns the
+// number of the failed ones
+unsigned long replayCases() {
+  unsigned long errors = 0;
+  uint8_t burst[9];
+  uint8_t read[9];
+  uint8_t old_value[4];
+  uint32_t new_value = 0x55667788UL;
+  uint16_t old_constant = constant;
+  uint8_t i;
+  
+  // A burst continues with the next register when the bytes of the current one
+  // are used up, both for writing and for reading
+  for (i = 0; i < 7; ++i) {
+    burst[i] = (uint8_t)nextRandom();
+  }
+  writeRegister(0x01, burst, 7);
+  if (value_1 != burst[0] || memcmp(&value_2, burst + 1, 2) || memcmp(&value_3, burst + 3, 4)) {
+    errors += fail("The burst write did not continue to the next registers");
+  }
+  readRegister(0x01, read, 7);
+  if (memcmp(read, burst, 7)) {
+    errors += fail("The burst read did not continue to the next registers");
+  }
+  
+  // The read only register ignores the writes, also when a burst reaches it
+  // (the unmapped 0x04 is skipped), and the read stops at the end of the map
+  writeRegister(0x05, burst, 2);
+  writeRegister(0x03, burst, 6);
+  if (constant != old_constant) {
+    errors += fail("The read only register was written");
+  }
+  readRegister(0x03, read, 8);
+  if (memcmp(read, burst, 4) || memcmp(read + 4, &old_constant, 2) || read[6] || read[7]) {
+    errors += fail("The burst read did not skip the unmapped ID or end with zeros");
+  }
+  
+  // The unmapped IDs (before, between and after the registers) ignore the
+  // writes and read as zeros
+  memcpy(read, &value_3, 4);
+  writeRegister(0x00, burst, 2);
+  writeRegister(0x04, burst, 2);
+  writeRegister(0xFF, burst, 2);
+  if (value_1 != burst[0] || memcmp(&value_2, burst + 1, 2) || memcmp(&value_3, read, 4)
+      || constant != old_constant) {
+    errors += fail("A write to an unmapped ID changed a register");
+  }
+  memset(burst, 0xFF, sizeof(burst));
+  readRegister(0x00, burst, 3);
+  readRegister(0x04, burst + 3, 3);
+  readRegister(0xFF, burst + 6, 3);
+  for (i = 0; i < 9; ++i) {
+    if (burst[i]) {
+      errors += fail("A read of an unmapped ID returned a non zero byte");
+      break;
+    }
+  }
+  
+  // The value changes after the first byte is sent (as by a higher priority
+  // interrupt), but the read gets all the bytes from the snapshot
+  memcpy(old_value, &value_3, 4);
+  beginRead(0x03);
+  read[0] = readByte();
+  value_3 = new_value;
+  for (i = 1; i < 4; ++i) {
+    read[i] = readByte();
+  }
+  endRead();
+  if (memcmp(read, old_value, 4)) {
+    errors += fail("The read of a changing value was torn");
+  }
+  readRegister(0x03, read, 4);
+  if (memcmp(read, &new_value, 4)) {
+    errors += fail("The read after the change did not return the new value");
+  }
+  
+  return errors;
+}
+
+int main(int argc, char** argv) {
+  
+  unsigned long rounds = (argc > 1) ? strtoul(argv[1], 0, 10) : 1000000;
+  unsigned long errors = 0;
+  unsigned long round;
+  uint8_t written[4];
+  uint8_t read[4];
+  uint8_t index;
+  uint8_t id;
+  uint8_t size;
+  uint8_t i;
+  clock_t start;
+  double seconds;
+  
+  // The register lookup needs the map sorted by ID
+  if (!regmapIsSorted(registers, regmapLength(registers))) {
+    fprintf(stderr, "The register map is not sorted by ID\n");
+    return 1;
+  }
+  
+  stm8HostReset();
+  i2cInitializeMode(0x55, 16, FAST);
+  
+  errors = replayCases();
+  
+  start = clock();
+  for (round = 0; round < rounds; ++round) {
+    index = nextRandom() % WRITABLE_REGISTERS;
+    id = regmapId(registers, index);
+    size = regmapSize(registers, index);
+    for (i = 0; i < size; ++i) {
+      written[i] = (uint8_t)nextRandom();
+    }
+    writeRegister(id, written, size);
+    readRegister(id, read, size);
+    if (memcmp(written, read, size) || memcmp(written, regmapPointer(registers, index), size)) {
+      if (errors < 10) {
+        fprintf(stderr, "Round %lu: register 0x%02X was not written or read correctly\n", round, id);
+      }
+      ++errors;
+    }
+  }
+  seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+  
+  printf("%lu transactions in %.2f s (%.0f transactions/s), %lu errors\n",
+         2 * rounds, seconds, seconds > 0 ? 2 * rounds / seconds : 0., errors);
+  return errors ? 1 : 0;
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   wheel_replay.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+/*
+ * Host harness (see stm8_host.h) which runs the WheelSpeedReader logic,
+ * included with its main renamed, with four wheels turning at constant speeds.
+ * The input pins change every few ms and the TIM4 overflows when its period
+ * ends, as the hardware would do. After every measurement the speeds are
+ * checked against the expected ones, allowing the error of one count per
+ * measurement period. It prints how many simulated seconds run per second.
+ * 
+ * Usage: wheel_replay [simulated seconds] (default 3600)
+ */
+
+#define main wheelSpeedReaderMain
+#include "../programs/WheelSpeedReader.c"
+#undef main
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+stm8HostRegisterFile()
+
+// The ms between the edges of every wheel
+const uint16_t half_periods[4] = {1, 3, 5, 20};
+
+int main(int argc, char** argv) {
+  
+  unsigned long seconds = (argc > 1) ? strtoul(argv[1], 0, 10) : 3600;
+  Wheel* wheels[4] = {&wheel_1, &wheel_2, &wheel_3, &wheel_4};
+  const uint8_t masks[4] = {
+    gpioPinMask(PIN_IN_1), gpioPinMask(PIN_IN_2), gpioPinMask(PIN_IN_3), gpioPinMask(PIN_IN_4)
+  };
+  unsigned long errors = 0;
+  unsigned long ms;
+  unsigned long next_overflow;
+  uint8_t port = 0;
+  uint8_t new_port;
+  uint8_t i;
+  double expected;
+  double measured;
+  clock_t start;
+  double elapsed;
+  
+  // The register lookup needs the map sorted by ID
+  if (!regmapIsSorted(registers, regmapLength(registers))) {
+    fprintf(stderr, "The register map is not sorted by ID\n");
+    return 1;
+  }
+  
+  stm8HostReset();
+  timerInitialize(16, TIMER_TICKLESS);
+  startWheel(&wheel_1);
+  startWheel(&wheel_2);
+  startWheel(&wheel_3);
+  startWheel(&wheel_4);
+  setupPinCounters();
+  port_in_state = port;
+  next_overflow = _timer_state.interval;
+  
+  start = clock();
+  for (ms = 1; ms <= seconds * 1000; ++ms) {
+    
+    // The edges of this ms
+    new_port = port;
+    for (i = 0; i < 4; ++i) {
+      if (ms % half_periods[i] == 0) {
+        new_port ^= masks[i];
+      }
+    }
+    if (new_port != port) {
+      port = new_port;
+      stm8HostSetPort(PORT_IN, port);
+#if INTERRUPT_COUNTING
+      countEdgesEvent();
+#else
+      countEdges();
+#endif
+    }
+    
+    if (ms != next_overflow) {
+      continue;
+    }
+    stm8HostTim4Overflow();
+    _timerInterruptHandler();
+    next_overflow += _timer_state.interval;
+    
+    // Check the speeds, after the first measurement
+    if (ms <= 2 * 100) {
+      continue;
+    }
+    for (i = 0; i < 4; ++i) {
+      expected = 1000. / half_periods[i];
+      measured = wheels[i]->speed / 65536.;
+      if (measured < expected - 1000. / wheels[i]->period - 0.01
+          || measured > expected + 1000. / wheels[i]->period + 0.01) {
+        if (errors < 10) {
+          fprintf(stderr, "%lu ms: wheel %u measured %.2f counts/sec instead of %.2f\n",
+                  ms, i + 1, measured, expected);
+        }
+        ++errors;
+      }
+    }
+  }
+  elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+  
+  printf("%lu simulated s in %.2f s (%.0f times real time), %lu errors\n",
+         seconds, elapsed, elapsed > 0 ? seconds / elapsed : 0., errors);
+  return errors ? 1 : 0;
+}
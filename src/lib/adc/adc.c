@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   adc.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <adc.h>
+
+void _adc(_AdcState* state) {
+  uint16_t channels;
+  bool stored;
+  
+  if (REGISTER_ADC_CSR & ADC_CSR_AWD) {
+    // With the data buffer the status registers tell which channels are out of
+    // the window, otherwise it is the converted one
+    if (state->buffered) {
+      channels = ((uint16_t)REGISTER_ADC_AWSRH << 8) | REGISTER_ADC_AWSRL;
+      // The flags are cleared by writing 0, so we clear only the ones we read
+      REGISTER_ADC_AWSRH = (uint8_t)~(channels >> 8);
+      REGISTER_ADC_AWSRL = (uint8_t)~channels;
+    } else {
+      channels = 1U << (REGISTER_ADC_CSR & _ADC_CSR_CH_MASK);
+    }
+    _adcCsrUnset(ADC_CSR_AWD);
+    if (state->on_watchdog) {
+      (*state->on_watchdog)(channels);
+    }
+  }
+  
+  if (REGISTER_ADC_CSR & ADC_CSR_EOC) {
+    stored = _adcConversionDone(state);
+    _adcCsrUnset(ADC_CSR_EOC);
+    // In continuous mode the data buffer is overwritten if we are late
+    if (REGISTER_ADC_CR3 & ADC_CR3_OVR) {
+      ++(state->overruns);
+      REGISTER_ADC_CR3 &= ~ADC_CR3_OVR;
+    }
+    if (stored && state->on_results) {
+      (*state->on_results)();
+    }
+  }
+}
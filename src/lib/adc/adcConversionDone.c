@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   adcConversionDone.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <adc.h>
+
+bool _adcConversionDone(_AdcState* state) {
+  uint8_t i;
+  uint8_t slot = 0;
+  uint16_t value;
+  bool stored = false;
+  for (i = 0; i < state->samples; ++i) {
+    if (state->buffered) {
+      value = _REGISTER_ADC_DBRL(i);
+      value |= (uint16_t)_REGISTER_ADC_DBRH(i) << 8;
+    } else {
+      value = REGISTER_ADC_DRL;
+      value |= (uint16_t)REGISTER_ADC_DRH << 8;
+    }
+    state->sum[slot] += value;
+    if (++slot < state->slots) {
+      continue;
+    }
+    // All the channels have a new sample, so we check if we have enough
+    slot = 0;
+    if (++(state->rounds) == (uint8_t)(1 << (2 * state->oversampling))) {
+      for (slot = 0; slot < state->slots; ++slot) {
+        state->result[slot] = state->sum[slot] >> state->oversampling;
+        state->sum[slot] = 0;
+      }
+      slot = 0;
+      state->rounds = 0;
+      ++(state->sequence);
+      stored = true;
+    }
+  }
+  return stored;
+}
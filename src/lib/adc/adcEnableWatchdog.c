@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   adcEnableWatchdog.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <adc.h>
+
+void adcEnableWatchdog(uint16_t channels, uint16_t low, uint16_t high) {
+  // The thresholds keep the 8 MSB in the high register and the 2 LSB in the
+  // low one
+  REGISTER_ADC_HTRH = (uint8_t)(high >> 2);
+  REGISTER_ADC_HTRL = (uint8_t)(high & 0x03);
+  REGISTER_ADC_LTRH = (uint8_t)(low >> 2);
+  REGISTER_ADC_LTRL = (uint8_t)(low & 0x03);
+  REGISTER_ADC_AWCRH = (uint8_t)(channels >> 8);
+  REGISTER_ADC_AWCRL = (uint8_t)channels;
+  _adcCsrSet(ADC_CSR_AWDIE);
+}
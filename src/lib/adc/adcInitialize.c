@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   adcInitialize.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <adc.h>
+
+void _adcInitialize(_AdcState* state, uint8_t spsel, uint8_t channel,
+                    uint8_t mode, uint8_t oversampling) {
+  uint8_t i;
+  uint16_t channels;
+  
+  REGISTER_ADC_CR1 = 0;
+  state->oversampling = oversampling;
+  state->rounds = 0;
+  for (i = 0; i < ADC_CHANNELS; ++i) {
+    state->sum[i] = 0;
+  }
+  
+  // In scan mode the channels 0 up to the given one are converted and one
+  // result of each is delivered in the data buffer. In continuous mode the
+  // data buffer gets ten successive results. In single mode there is a single
+  // result in the data register.
+  state->slots = (mode & ADC_SCAN) ? channel + 1 : 1;
+  state->samples = (mode & ADC_SCAN) ? channel + 1 : (mode & ADC_CONTINUOUS) ? 10 : 1;
+  state->buffered = mode != ADC_SINGLE;
+  
+  // Disable the Schmitt triggers of the analog inputs, to reduce the
+  // consumption
+  channels = (mode & ADC_SCAN) ? (uint16_t)((2U << channel) - 1) : (uint16_t)(1U << channel);
+  REGISTER_ADC_TDRH = (uint8_t)(channels >> 8);
+  REGISTER_ADC_TDRL = (uint8_t)channels;
+  
+  REGISTER_ADC_CSR = ADC_CSR_EOCIE | channel;
+  REGISTER_ADC_CR2 = ADC_CR2_ALIGN | ((mode & ADC_SCAN) ? ADC_CR2_SCAN : 0);
+  REGISTER_ADC_CR3 = (mode & ADC_CONTINUOUS) ? ADC_CR3_DBUF : 0;
+  REGISTER_ADC_CR1 = (uint8_t)(spsel << _ADC_CR1_SPSEL_SHIFT)
+                     | ((mode & ADC_CONTINUOUS) ? ADC_CR1_CONT : 0);
+  
+  // The first ADON wakes up the ADC, which needs 7us before the first
+  // conversion is started with the adcStart()
+  registerSet(REGISTER_ADC_CR1, ADC_CR1_ADON);
+}
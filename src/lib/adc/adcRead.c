@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   adcRead.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <adc.h>
+
+uint16_t _adcRead(_AdcState* state, uint8_t channel) {
+  uint16_t result;
+  __critical {
+    result = state->result[channel];
+  }
+  return result;
+}
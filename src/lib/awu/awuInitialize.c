@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   awuInitialize.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <awu.h>
+
+void awuInitialize(uint32_t lsi, uint16_t interval) {
+  uint32_t ticks = (uint32_t)interval * (lsi / 10) / 100;
+  uint32_t multiplier = 1;
+  uint8_t timebase = 1;
+  uint32_t divider;
+  
+  while (timebase < 15 && ticks > 64 * multiplier) {
+    ++timebase;
+    multiplier = (timebase == 14) ? 10240 : (timebase == 15) ? 61440 : (multiplier << 1);
+  }
+  divider = (ticks + multiplier / 2) / multiplier;
+  if (divider < 2) {
+    divider = 2;
+  }
+  if (divider > 64) {
+    divider = 64;
+  }
+  
+  // The prescaler must be set before the timebase
+  REGISTER_AWU_CSR &= ~AWU_CSR_AWUEN;
+  REGISTER_AWU_APR = (uint8_t)(divider - 2);
+  REGISTER_AWU_TBR = timebase;
+  registerSet(REGISTER_AWU_CSR, AWU_CSR_AWUEN);
+  
+  registerSet(REGISTER_CLK_ICKR, _CLK_ICKR_REGAH);
+  registerSet(REGISTER_FLASH_CR1, _FLASH_CR1_AHALT);
+}
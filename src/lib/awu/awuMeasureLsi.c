@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   awuMeasureLsi.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <awu.h>
+
+uint32_t awuMeasureLsi(uint8_t frequency) {
+  uint8_t i;
+  uint16_t previous;
+  uint16_t current;
+  uint32_t total = 0;
+  uint8_t overflows;
+  
+  registerSet(REGISTER_AWU_CSR, AWU_CSR_MSR);
+  REGISTER_TIM1_CCMR1 = TIM1_CCMR_CC_TI | TIM1_CCMR_ICPSC_8;
+  REGISTER_TIM1_CCER1 = TIM1_CCER1_CC1E;
+  REGISTER_TIM1_CR1 = TIM1_CR1_CEN;
+  
+  // Every capture is 8 LSI periods after the previous one. The capture
+  // registers must be read with the high byte first.
+  for (i = 0; i <= _AWU_MEASURE_GROUPS; ++i) {
+    REGISTER_TIM1_SR1 = 0;
+    // The TIM1 overflows every 65536 f_master periods, which is much longer
+    // than 8 LSI periods, so a second overflow means that the LSI is stopped
+    overflows = 0;
+    while (!(REGISTER_TIM1_SR1 & TIM1_SR1_CC1IF) && overflows < 2) {
+      if (REGISTER_TIM1_SR1 & TIM1_SR1_UIF) {
+        REGISTER_TIM1_SR1 = (uint8_t)~TIM1_SR1_UIF;
+        ++overflows;
+      }
+    }
+    if (overflows == 2) {
+      total = 0;
+      break;
+    }
+    current = (uint16_t)REGISTER_TIM1_CCR1H << 8;
+    current |= REGISTER_TIM1_CCR1L;
+    if (i > 0) {
+      total += (uint16_t)(current - previous);
+    }
+    previous = current;
+  }
+  
+  REGISTER_TIM1_CR1 = 0;
+  REGISTER_TIM1_CCER1 = 0;
+  REGISTER_TIM1_CCMR1 = 0;
+  REGISTER_TIM1_CNTRH = 0;
+  REGISTER_TIM1_CNTRL = 0;
+  REGISTER_AWU_CSR &= ~AWU_CSR_MSR;
+  
+  if (total == 0) {
+    return 0;
+  }
+  return (uint32_t)frequency * 1000000UL * 8 * _AWU_MEASURE_GROUPS / total;
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   clkCalibrateHsi.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <clk_trim.h>
+
+bool clkCalibrateHsi(uint32_t (*measure)(void), uint32_t expected, HsiTrimResult* result) {
+  int8_t initial = clkGetHsiTrim();
+  int8_t trim = initial;
+  int8_t step;
+  uint32_t measured;
+  int32_t error;
+  
+  measured = measure();
+  if (measured == 0) {
+    return false;
+  }
+  result->trim = trim;
+  result->error_ppm = _clkTrimError(measured, expected);
+  
+  // Too many ticks means that the f_master is too fast
+  step = (result->error_ppm > 0) ? -1 : 1;
+  while (result->error_ppm != 0 && trim + step >= CLK_HSI_TRIM_MIN && trim + step <= CLK_HSI_TRIM_MAX) {
+    trim += step;
+    clkSetHsiTrim(trim);
+    measured = measure();
+    if (measured == 0) {
+      clkSetHsiTrim(initial);
+      return false;
+    }
+    error = _clkTrimError(measured, expected);
+    if ((error < 0 ? -error : error) < (result->error_ppm < 0 ? -result->error_ppm : result->error_ppm)) {
+      result->trim = trim;
+      result->error_ppm = error;
+    }
+    // Stop when we passed the expected value or the error did not improve
+    if ((error > 0) != (step < 0) || result->trim != trim) {
+      break;
+    }
+  }
+  
+  clkSetHsiTrim(result->trim);
+  return true;
+}
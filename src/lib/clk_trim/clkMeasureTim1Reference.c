@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   clkMeasureTim1Reference.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <clk_trim.h>
+
+uint32_t clkMeasureTim1Reference() {
+  uint8_t overflows = 0;
+  bool started = false;
+  uint16_t previous;
+  uint16_t current;
+  
+  REGISTER_TIM1_SR1 = 0;
+  REGISTER_TIM1_SR2 = 0;
+  while (overflows <= _CLK_TRIM_TIMEOUT) {
+    if (REGISTER_TIM1_SR1 & TIM1_SR1_UIF) {
+      // Writing 1 to the other flags has no effect, so a capture which occurs
+      // in the meantime is not lost
+      REGISTER_TIM1_SR1 = (uint8_t)~TIM1_SR1_UIF;
+      ++overflows;
+    }
+    // Reading the capture register (high byte first) clears the flag
+    if (REGISTER_TIM1_SR1 & TIM1_SR1_CC2IF) {
+      current = (uint16_t)REGISTER_TIM1_CCR2H << 8;
+      current |= REGISTER_TIM1_CCR2L;
+      if (started) {
+        return (uint16_t)(current - previous);
+      }
+      previous = current;
+      started = true;
+      overflows = 0;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   clkStartTim1Reference.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <clk_trim.h>
+
+void clkStartTim1Reference(uint32_t prescaler) {
+  --prescaler;
+  REGISTER_TIM1_PSCRH = (uint8_t)(prescaler >> 8);
+  REGISTER_TIM1_PSCRL = (uint8_t)prescaler;
+  REGISTER_TIM1_ARRH = 0xFF;
+  REGISTER_TIM1_ARRL = 0xFF;
+  REGISTER_TIM1_CCMR2 = TIM1_CCMR_CC_TI;
+  REGISTER_TIM1_CCER1 = TIM1_CCER1_CC2E;
+  // The prescaler is loaded only at the next update event
+  REGISTER_TIM1_EGR = TIM1_EGR_UG;
+  REGISTER_TIM1_CR1 = TIM1_CR1_CEN;
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   debounceInitialize.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <debounce.h>
+
+void _debounceInitialize(Debouncer* debouncer, const volatile uint8_t* input,
+                         uint8_t samples, void (*on_edges)(uint8_t, uint8_t)) {
+  // A pin changes state when its counter reaches samples - 1 and it is read
+  // with the new level once more
+  uint8_t limit = samples - 1;
+  
+  debouncer->input = input;
+  debouncer->state = *input;
+  debouncer->count0 = 0;
+  debouncer->count1 = 0;
+  debouncer->count2 = 0;
+  debouncer->limit0 = (limit & 0b001) ? 0xFF : 0;
+  debouncer->limit1 = (limit & 0b010) ? 0xFF : 0;
+  debouncer->limit2 = (limit & 0b100) ? 0xFF : 0;
+  debouncer->on_edges = on_edges;
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   debounceSample.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <debounce.h>
+
+void _debounceSample(void* context) {
+  Debouncer* debouncer = context;
+  uint8_t count0 = debouncer->count0;
+  uint8_t count1 = debouncer->count1;
+  
+  // The pins which are read with a different level than their debounced state
+  uint8_t different = *debouncer->input ^ debouncer->state;
+  
+  // The pins which were different for enough samples change state
+  uint8_t changed = different & ~((count0 ^ debouncer->limit0)
+                                  | (count1 ^ debouncer->limit1)
+                                  | (debouncer->count2 ^ debouncer->limit2));
+  
+  // The counters of the other different pins are increased and all the rest
+  // are reset
+  different &= ~changed;
+  debouncer->count2 = (debouncer->count2 ^ (count1 & count0)) & different;
+  debouncer->count1 = (count1 ^ count0) & different;
+  debouncer->count0 = ~count0 & different;
+  
+  if (changed) {
+    debouncer->state ^= changed;
+    if (debouncer->on_edges) {
+      debouncer->on_edges(changed & debouncer->state, changed & ~debouncer->state);
+    }
+  }
+}
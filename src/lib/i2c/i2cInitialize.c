@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   i2cInitialize.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <i2c.h>
+
+void _i2cInitialize(uint8_t address, uint8_t frequency,
+                    uint8_t ccrh, uint8_t ccrl, uint8_t trise, uint8_t options) {
+  
+  // Disable the I2C peripheral
+  registerUnset(REGISTER_I2C_CR1, I2C_CR1_PE);
+  
+  // Set the address
+  registerUnset(REGISTER_I2C_OARH, I2C_OARH_ADDMODE); // Use 7-bit address
+  registerSet(REGISTER_I2C_OARH, I2C_OARH_ADDCONF); // Must always be 1
+  REGISTER_I2C_OARL = (uint8_t)(address << 1); // Write own address
+  
+  // Set the input frequency
+  REGISTER_I2C_FREQR = frequency;
+  
+  // Set the speed mode and the clock control. The CCR must be written while
+  // the peripheral is disabled.
+  REGISTER_I2C_CCRL = ccrl;
+  REGISTER_I2C_CCRH = ccrh;
+  
+  // Set the maximum rise time
+  REGISTER_I2C_TRISER = trise;
+  
+  // Enable the interrupts
+  registerSet(REGISTER_I2C_ITR, I2C_ITR_ITBUFEN);
+  registerSet(REGISTER_I2C_ITR, I2C_ITR_ITEVTEN);
+  registerSet(REGISTER_I2C_ITR, I2C_ITR_ITERREN);
+  
+  // The wakeup from halt needs the clock stretching, which holds the SCL low
+  // after the address match until the clocks are restarted. The HSI is used
+  // after the wakeup, because it starts much faster than the HSE.
+  if (options & I2C_WAKEUP_FROM_HALT) {
+    registerUnset(REGISTER_I2C_CR1, I2C_CR1_NOO_STRETCH);
+    registerSet(REGISTER_CLK_ICKR, _CLK_ICKR_FHWU);
+  }
+  
+  // Enable the I2C peripheral
+  registerSet(REGISTER_I2C_CR1, I2C_CR1_PE);
+  
+  // Send ACK after bytes (default I2C expectation)
+  registerSet(REGISTER_I2C_CR2, I2C_CR2_ACK);
+}
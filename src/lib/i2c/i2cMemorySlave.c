@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   i2cMemorySlave.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <i2c.h>
+
+void _i2cMemorySlave(_I2cMemorySlaveState* state) {
+  
+  // Wakeup from halt, which is followed by the address match event. The flag
+  // must be cleared, otherwise the interrupt is triggered again. The SR2 flags
+  // are cleared by writing 0 and writing 1 has no effect, so the register is
+  // written directly. A read-modify-write would also clear an error flag which
+  // sets in between.
+  if (REGISTER_I2C_SR2 & I2C_SR2_WUFH) {
+    REGISTER_I2C_SR2 = (uint8_t)~I2C_SR2_WUFH;
+  }
+  
+  // Event EV1
+  if (REGISTER_I2C_SR1 & I2C_SR1_ADDR) {
+    // A repeated start finishes the previous write, so we commit it
+    _memorySlaveCommit(&state->memory);
+    // Read the SR3 to unblock the I2C. If the master is going to read, we take
+    // a snapshot of the memory, so all the bytes belong to the same value.
+    if (REGISTER_I2C_SR3 & I2C_SR3_TRA) {
+      _memorySlaveSnapshot(&state->memory);
+    }
+    state->read_id = true; // We just got the address so we set that we want to read the ID
+    return;
+  }
+  
+  // Event EV2
+  if (REGISTER_I2C_SR1 & I2C_SR1_RXNE) {
+    if (state->read_id) {
+      _memorySlaveSelect(&state->memory, REGISTER_I2C_DR);
+      state->read_id = false; // All rest bytes should be written in memory
+    } else {
+      _memorySlaveWrite(&state->memory, REGISTER_I2C_DR);
+    }
+    return;
+  }
+  
+  // Even EV3
+  if (REGISTER_I2C_SR1 & I2C_SR1_TXE) {
+    REGISTER_I2C_DR = _memorySlaveRead(&state->memory);
+    return;
+  }
+  
+  // Event EV3-2
+  if (REGISTER_I2C_SR2 & I2C_SR2_AF) {
+    REGISTER_I2C_SR2 = (uint8_t)~I2C_SR2_AF;
+    return;
+  }
+  
+  // Event EV4
+  if (REGISTER_I2C_SR1 & I2C_SR1_STOPF) {
+    registerSet(REGISTER_I2C_CR2, I2C_CR2_ACK);
+    // The write is finished, so we commit the buffered bytes at once
+    _memorySlaveCommit(&state->memory);
+    return;
+  }
+  
+}
@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   i2cMaster.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <i2c_master.h>
+
+void _i2cMaster(_I2cMasterState* state) {
+  I2cTransaction* transaction = state->queue[state->head & _I2C_MASTER_QUEUE_MASK];
+  uint8_t sr1 = REGISTER_I2C_SR1;
+  uint8_t sr2;
+  
+  // An interrupt without a transaction cannot be handled, we just clear it
+  if (!state->busy) {
+    REGISTER_I2C_SR2 = 0;
+    return;
+  }
+  
+  // Acknowledge failure, arbitration lost or bus error
+  sr2 = REGISTER_I2C_SR2;
+  if (sr2 & (I2C_SR2_AF | I2C_SR2_ARLO | I2C_SR2_BERR)) {
+    REGISTER_I2C_SR2 = 0;
+    _i2cMasterRelease(state, !(sr2 & I2C_SR2_ARLO));
+    _i2cMasterFinish(state, I2C_TRANSACTION_ERROR);
+    return;
+  }
+  
+  // Event EV5
+  if (sr1 & I2C_SR1_SB) {
+    state->starting = false;
+    registerSet(REGISTER_I2C_ITR, I2C_ITR_ITBUFEN);
+    // The START request is cleared, so the CR2 can be written
+    if (state->reading && state->remaining == 2) {
+      registerSet(REGISTER_I2C_CR2, I2C_CR2_POS);
+    } else {
+      REGISTER_I2C_CR2 &= ~I2C_CR2_POS;
+    }
+    registerSet(REGISTER_I2C_CR2, I2C_CR2_ACK);
+    REGISTER_I2C_DR = (uint8_t)(transaction->address << 1) | (state->reading ? 1 : 0);
+    return;
+  }
+  
+  // The BTF and TXE of the previous phase stay set until the requested START is
+  // generated, so they must not be taken for events of the new phase
+  if (state->starting) {
+    return;
+  }
+  
+  // Event EV6
+  if (sr1 & I2C_SR1_ADDR) {
+    if (state->reading && state->remaining == 1) {
+      // The single byte must not be acknowledged, which must be set before
+      // clearing the ADDR
+      REGISTER_I2C_CR2 &= ~I2C_CR2_ACK;
+      REGISTER_I2C_SR3;
+      _i2cMasterRelease(state, true);
+    } else if (state->reading && state->remaining == 2) {
+      // With the POS set the NACK applies to the second byte
+      REGISTER_I2C_SR3;
+      REGISTER_I2C_CR2 &= ~I2C_CR2_ACK;
+      REGISTER_I2C_ITR &= ~I2C_ITR_ITBUFEN;
+    } else if (state->reading) {
+      REGISTER_I2C_SR3;
+      if (state->remaining == 3) {
+        REGISTER_I2C_ITR &= ~I2C_ITR_ITBUFEN;
+      }
+    } else {
+      REGISTER_I2C_SR3;
+      // Nothing to write or read, the slave is just probed
+      if (state->remaining == 0 && transaction->read_size == 0) {
+        _i2cMasterRelease(state, true);
+        _i2cMasterFinish(state, I2C_TRANSACTION_DONE);
+      }
+    }
+    return;
+  }
+  
+  if (state->reading) {
+    // Event EV7_2 (BTF with the last bytes)
+    if (state->remaining == 3 && (sr1 & I2C_SR1_BTF)) {
+      // Byte N-2 is in DR and N-1 in the shift register, so N gets the NACK
+      REGISTER_I2C_CR2 &= ~I2C_CR2_ACK;
+      *(state->ptr++) = REGISTER_I2C_DR;
+      --(state->remaining);
+      return;
+    }
+    if (state->remaining == 2 && (sr1 & I2C_SR1_BTF)) {
+      // Both the last bytes are received
+      _i2cMasterRelease(state, true);
+      *(state->ptr++) = REGISTER_I2C_DR;
+      *(state->ptr++) = REGISTER_I2C_DR;
+      state->remaining = 0;
+      _i2cMasterFinish(state, I2C_TRANSACTION_DONE);
+      return;
+    }
+    // Event EV7
+    if ((state->remaining > 3 || state->remaining == 1) && (sr1 & I2C_SR1_RXNE)) {
+      *(state->ptr++) = REGISTER_I2C_DR;
+      --(state->remaining);
+      if (state->remaining == 3) {
+        REGISTER_I2C_ITR &= ~I2C_ITR_ITBUFEN;
+      }
+      if (state->remaining == 0) {
+        _i2cMasterFinish(state, I2C_TRANSACTION_DONE);
+      }
+    }
+    return;
+  }
+  
+  // Event EV8_2
+  if (state->remaining == 0 && (sr1 & I2C_SR1_BTF)) {
+    if (transaction->read_size > 0) {
+      state->reading = true;
+      _i2cMasterSetupPhase(state);
+      registerSet(REGISTER_I2C_CR2, I2C_CR2_START);
+    } else {
+      _i2cMasterRelease(state, true);
+      _i2cMasterFinish(state, I2C_TRANSACTION_DONE);
+    }
+    return;
+  }
+  
+  // Event EV8
+  if (state->remaining > 0 && (sr1 & I2C_SR1_TXE)) {
+    REGISTER_I2C_DR = *(state->ptr++);
+    --(state->remaining);
+    // After the last byte we only wait for the BTF
+    if (state->remaining == 0) {
+      REGISTER_I2C_ITR &= ~I2C_ITR_ITBUFEN;
+    }
+    return;
+  }
+  
+}
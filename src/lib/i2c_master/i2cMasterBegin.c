@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   i2cMasterBegin.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <i2c_master.h>
+
+void _i2cMasterBegin(_I2cMasterState* state) {
+  I2cTransaction* transaction = state->queue[state->head & _I2C_MASTER_QUEUE_MASK];
+  state->busy = true;
+  state->reading = transaction->write_size == 0 && transaction->read_size > 0;
+  _i2cMasterSetupPhase(state);
+  if (state->restarting) {
+    // The repeated START was requested when the previous transaction ended
+    state->restarting = false;
+  } else {
+    // If the STOP of the previous transaction is still being generated we must
+    // wait for it (at most one SCL period) before requesting the next START
+    while (REGISTER_I2C_CR2 & I2C_CR2_STOP);
+    registerSet(REGISTER_I2C_CR2, I2C_CR2_START);
+  }
+}
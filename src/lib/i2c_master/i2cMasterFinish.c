@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   i2cMasterFinish.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <i2c_master.h>
+
+void _i2cMasterFinish(_I2cMasterState* state, uint8_t status) {
+  state->queue[state->head & _I2C_MASTER_QUEUE_MASK]->status = status;
+  ++(state->head);
+  if (state->head != state->tail) {
+    _i2cMasterBegin(state);
+  } else {
+    state->busy = false;
+    state->restarting = false;
+  }
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   i2cMasterRelease.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <i2c_master.h>
+
+void _i2cMasterRelease(_I2cMasterState* state, bool stop) {
+  state->restarting = (uint8_t)(state->head + 1) != state->tail;
+  if (state->restarting) {
+    registerSet(REGISTER_I2C_CR2, I2C_CR2_START);
+  } else if (stop) {
+    registerSet(REGISTER_I2C_CR2, I2C_CR2_STOP);
+  }
+}
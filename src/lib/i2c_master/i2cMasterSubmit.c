@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   i2cMasterSubmit.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <i2c_master.h>
+
+bool _i2cMasterSubmit(_I2cMasterState* state, I2cTransaction* transaction) {
+  bool result = false;
+  __critical {
+    if ((uint8_t)(state->tail - state->head) < I2C_MASTER_QUEUE_SIZE) {
+      transaction->status = I2C_TRANSACTION_PENDING;
+      state->queue[state->tail & _I2C_MASTER_QUEUE_MASK] = transaction;
+      ++(state->tail);
+      if (!state->busy) {
+        _i2cMasterBegin(state);
+      }
+      result = true;
+    }
+  }
+  return result;
+}
@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   memorySlaveCommit.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <memory_slave.h>
+
+void _memorySlaveCommit(_MemorySlaveState* state) {
+  uint8_t i;
+  // The interrupts are disabled, so no other interrupt (even of a higher
+  // priority) sees the memory half-written
+  __critical {
+    for (i = 0; i < state->written; ++i) {
+      state->target[i] = state->buffer[i];
+    }
+  }
+  state->written = 0;
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   memorySlaveRead.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <memory_slave.h>
+
+uint8_t _memorySlaveRead(_MemorySlaveState* state) {
+  if (state->size == 0 && state->map && state->target) {
+    if (_memorySlaveNext(state)) {
+      _memorySlaveSnapshot(state);
+    }
+  }
+  if (state->size > 0) {
+    --(state->size);
+    return *(state->ptr++);
+  }
+  return 0;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   memorySlaveSelect.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <memory_slave.h>
+
+void _memorySlaveSelect(_MemorySlaveState* state, uint8_t id) {
+  const RegmapEntry* map = state->map;
+  uint16_t low = 0;
+  uint16_t high;
+  uint16_t middle;
+  
+  if (map) {
+    // With a register map the ID is searched in the table, which is sorted. The
+    // registers before the low have smaller IDs and the ones from the high on
+    // have equal or greater IDs.
+    high = state->map_length;
+    while (low < high) {
+      middle = (low + high) >> 1;
+      if (map[middle].id < id) {
+        low = middle + 1;
+      } else {
+        high = middle;
+      }
+    }
+    if (low < state->map_length && map[low].id == id) {
+      _memorySlaveSelectEntry(state, low);
+      return;
+    }
+    state->target = 0;
+  } else {
+    // Otherwise we use the user method to get the pointer and the size
+    state->target = (*state->handle_id)(id, &state->size);
+    state->read_only = false;
+  }
+  state->id = id;
+  _memorySlaveAccess(state);
+}
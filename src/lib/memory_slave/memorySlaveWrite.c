@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   memorySlaveWrite.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <memory_slave.h>
+
+void _memorySlaveWrite(_MemorySlaveState* state, uint8_t data) {
+  if (state->size == 0 && state->map && state->target) {
+    _memorySlaveNext(state);
+  }
+  if (state->size > 0) {
+    if (!state->read_only) {
+      *(state->ptr) = data;
+      if (state->buffered) {
+        ++(state->written);
+      }
+    }
+    ++(state->ptr);
+    --(state->size);
+  }
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   spiInitializeMaster.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <spi_master.h>
+
+void _spiInitializeMaster(uint8_t cr1) {
+  REGISTER_SPI_CR1 = 0;
+  // The NSS pin is not used, the slaves must be selected with GPIOs
+  REGISTER_SPI_CR2 = SPI_CR2_SSM | SPI_CR2_SSI;
+  REGISTER_SPI_ICR = 0;
+  REGISTER_SPI_CR1 = cr1 | SPI_CR1_MSTR;
+  registerSet(REGISTER_SPI_CR1, SPI_CR1_SPE);
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   spiMaster.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <spi_master.h>
+
+void _spiMaster(_SpiMasterState* state) {
+  uint8_t sr;
+  while (1) {
+    sr = REGISTER_SPI_SR;
+    if (sr & SPI_SR_RXNE) {
+      // A byte was received, so we store it
+      if (state->rx) {
+        state->rx[state->rx_count] = REGISTER_SPI_DR;
+      } else {
+        REGISTER_SPI_DR;
+      }
+      ++(state->rx_count);
+      if (state->rx_count == state->size) {
+        // The transfer is complete
+        REGISTER_SPI_ICR = 0;
+        state->busy = false;
+        if (state->on_complete) {
+          (*state->on_complete)();
+        }
+        return;
+      }
+    } else if ((sr & SPI_SR_TXE) && state->tx_count < state->size
+               && (uint8_t)(state->tx_count - state->rx_count) < 2) {
+      // The DR is empty and at most one byte is in the shift register, so we
+      // preload the next one
+      REGISTER_SPI_DR = state->tx ? state->tx[state->tx_count] : 0xFF;
+      ++(state->tx_count);
+      if (state->tx_count == state->size) {
+        REGISTER_SPI_ICR &= ~SPI_ICR_TXIE;
+      }
+    } else {
+      return;
+    }
+  }
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   spiTransfer.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <spi_master.h>
+
+bool _spiTransfer(_SpiMasterState* state, const uint8_t* tx, uint8_t* rx, uint8_t size) {
+  if (state->busy || size == 0) {
+    return false;
+  }
+  state->tx = tx;
+  state->rx = rx;
+  state->size = size;
+  state->tx_count = 0;
+  state->rx_count = 0;
+  state->busy = true;
+  REGISTER_SPI_ICR = SPI_ICR_TXIE | SPI_ICR_RXIE;
+  return true;
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   spiInitializeSlave.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <spi_slave.h>
+
+void spiInitializeSlave(uint8_t mode) {
+  REGISTER_SPI_CR1 = 0;
+  // The NSS pin is managed by the hardware
+  REGISTER_SPI_CR2 = 0;
+  REGISTER_SPI_CR1 = mode;
+  
+  // The NSS is pulled up, so the slave is not selected if it is unconnected,
+  // and its rising edge triggers the Port A interrupt
+  gpioSetAsPullUp(A, 3);
+  gpioEnableInterrupt(A, 3);
+  itcSetPortSensitivity(A, ITC_EXT_RISE);
+  
+  // Preload the byte sent at the first position of the first frame
+  REGISTER_SPI_DR = 0xFF;
+  REGISTER_SPI_ICR = SPI_ICR_TXIE | SPI_ICR_RXIE;
+  registerSet(REGISTER_SPI_CR1, SPI_CR1_SPE);
+}
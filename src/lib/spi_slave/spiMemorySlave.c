@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   spiMemorySlave.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <spi_slave.h>
+
+void _spiMemorySlave(_SpiMemorySlaveState* state) {
+  uint8_t sr;
+  while (1) {
+    sr = REGISTER_SPI_SR;
+    if (sr & SPI_SR_RXNE) {
+      _spiMemorySlaveReceive(state, REGISTER_SPI_DR);
+    } else if (sr & SPI_SR_TXE) {
+      if (state->command == SPI_MEMORY_SLAVE_READ && state->rx_position == 2
+          && state->tx_position == _SPI_MEMORY_SLAVE_READ_POSITION) {
+        REGISTER_SPI_DR = _memorySlaveRead(&state->memory);
+      } else {
+        REGISTER_SPI_DR = 0xFF;
+      }
+      if (state->tx_position < _SPI_MEMORY_SLAVE_READ_POSITION) {
+        ++(state->tx_position);
+      }
+    } else {
+      return;
+    }
+  }
+}
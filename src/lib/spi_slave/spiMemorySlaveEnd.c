@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   spiMemorySlaveEnd.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <spi_slave.h>
+
+void _spiMemorySlaveEnd(_SpiMemorySlaveState* state) {
+  if (!gpioReadInput(A, 3)) {
+    return;
+  }
+  // The last byte might not be handled yet, because the Port A interrupt has
+  // higher hardware priority than the SPI one
+  if (REGISTER_SPI_SR & SPI_SR_RXNE) {
+    _spiMemorySlaveReceive(state, REGISTER_SPI_DR);
+  }
+  // The write is finished, so we commit the buffered bytes at once
+  _memorySlaveCommit(&state->memory);
+  state->command = 0;
+  state->rx_position = 0;
+  // Make sure a byte is waiting in the DR, so the next byte written goes to
+  // the second position of the next frame. If the DR is not empty, it keeps a
+  // byte of this frame, which is sent at the first position of the next one.
+  if (REGISTER_SPI_SR & SPI_SR_TXE) {
+    REGISTER_SPI_DR = 0xFF;
+  }
+  state->tx_position = 1;
+}
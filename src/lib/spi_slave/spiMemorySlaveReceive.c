@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   spiMemorySlaveReceive.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <spi_slave.h>
+
+void _spiMemorySlaveReceive(_SpiMemorySlaveState* state, uint8_t data) {
+  if (state->rx_position == 0) {
+    state->command = data;
+  } else if (state->rx_position == 1) {
+    _memorySlaveSelect(&state->memory, data);
+    // For reads we take a snapshot, so all the bytes belong to the same value
+    if (state->command == SPI_MEMORY_SLAVE_READ) {
+      _memorySlaveSnapshot(&state->memory);
+    }
+  } else if (state->command == SPI_MEMORY_SLAVE_WRITE) {
+    _memorySlaveWrite(&state->memory, data);
+  }
+  if (state->rx_position < 2) {
+    ++(state->rx_position);
+  }
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   timer.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <timer.h>
+
+void _timer(_TimerState* state) {
+  uint8_t elapsed = state->interval;
+  Timer* timer;
+  
+  REGISTER_TIM4_SR &= ~TIM4_SR_UIF;
+  
+  // Subtract the TIM4 period from the list. Only the expired timers and the
+  // first one which has not expired are visited.
+  for (timer = state->head; timer && elapsed; timer = timer->next) {
+    if (timer->delta > elapsed) {
+      timer->delta -= elapsed;
+      break;
+    }
+    elapsed -= timer->delta;
+    timer->delta = 0;
+  }
+  
+  // Call the expired timers. The periodic ones are inserted again before their
+  // callback, so the callback can stop or restart them.
+  while (state->head && state->head->delta == 0) {
+    timer = state->head;
+    state->head = timer->next;
+    timer->active = false;
+    if (timer->period) {
+      _timerInsert(state, timer, timer->period);
+    }
+    timer->callback(timer->context);
+  }
+  
+  _timerSchedule(state);
+}
@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   timerInitialize.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <timer.h>
+
+void _timerInitialize(_TimerState* state, uint8_t prescaler, bool tickless) {
+  state->head = 0;
+  state->interval = 1;
+  state->tickless = tickless;
+  REGISTER_TIM4_PSCR = prescaler;
+  REGISTER_TIM4_ARR = _TIMER_TICKS_PER_MS - 1;
+  // The prescaler is loaded only at the next update event
+  REGISTER_TIM4_EGR = TIM4_EGR_UG;
+  tim4EnableInterrupt();
+  if (!tickless) {
+    tim4Start();
+  }
+}
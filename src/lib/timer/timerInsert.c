@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   timerInsert.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <timer.h>
+
+void _timerInsert(_TimerState* state, Timer* timer, uint16_t delay) {
+  Timer** link = &state->head;
+  
+  while (*link && (*link)->delta <= delay) {
+    delay -= (*link)->delta;
+    link = &(*link)->next;
+  }
+  if (*link) {
+    (*link)->delta -= delay;
+  }
+  timer->delta = delay;
+  timer->next = *link;
+  timer->active = true;
+  *link = timer;
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   timerSchedule.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <timer.h>
+
+void _timerSchedule(_TimerState* state) {
+  if (!state->tickless) {
+    return;
+  }
+  if (!state->head) {
+    REGISTER_TIM4_CR1 &= ~TIM4_CR1_CEN;
+    REGISTER_TIM4_CNTR = 0;
+    return;
+  }
+  state->interval = (state->head->delta < _TIMER_MAX_INTERVAL) ? state->head->delta : _TIMER_MAX_INTERVAL;
+  REGISTER_TIM4_ARR = state->interval * _TIMER_TICKS_PER_MS - 1;
+}
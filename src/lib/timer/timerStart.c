@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   timerStart.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <timer.h>
+
+void _timerStart(_TimerState* state, Timer* timer, uint16_t delay, uint16_t period) {
+  bool overflow;
+  uint8_t ticks;
+  
+  if (delay == 0) {
+    delay = 1;
+  }
+  
+  __critical {
+    if (timer->active) {
+      _timerRemove(state, timer);
+    }
+    timer->period = period;
+    
+    if (!(REGISTER_TIM4_CR1 & TIM4_CR1_CEN)) {
+      // The TIM4 was stopped by the tickless mode, so a new period starts now
+      _timerInsert(state, timer, delay);
+      _timerSchedule(state);
+      tim4Start();
+    } else {
+      // The delay is counted from now, so we add the time passed since the
+      // start of the TIM4 period, rounded up so the delay is never shortened.
+      // If the TIM4 overflowed and the interrupt is pending, its whole period
+      // has passed too.
+      do {
+        overflow = REGISTER_TIM4_SR & TIM4_SR_UIF;
+        ticks = REGISTER_TIM4_CNTR;
+      } while (overflow != (bool)(REGISTER_TIM4_SR & TIM4_SR_UIF));
+      delay += (ticks + _TIMER_TICKS_PER_MS - 1) / _TIMER_TICKS_PER_MS;
+      if (overflow) {
+        delay += state->interval;
+      }
+      _timerInsert(state, timer, delay);
+      
+      // A new first timer might expire before the end of the TIM4 period
+      if (timer->delta < state->interval) {
+        state->interval = timer->delta;
+        REGISTER_TIM4_ARR = state->interval * _TIMER_TICKS_PER_MS - 1;
+      }
+    }
+  }
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   uart1Get.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <uart.h>
+
+uint8_t _uart1Get(_Uart1State* state, uint8_t* data, uint8_t size) {
+  uint8_t count = 0;
+  while (count < size && state->rx_head != state->rx_tail) {
+    data[count] = state->rx[state->rx_head & _UART1_RX_MASK];
+    ++(state->rx_head);
+    ++count;
+  }
+  return count;
+}
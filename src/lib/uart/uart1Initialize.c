@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   uart1Initialize.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <uart.h>
+
+void _uart1Initialize(uint16_t divider) {
+  // Disable the transmitter and the receiver while configuring
+  REGISTER_UART1_CR2 = 0;
+  REGISTER_UART1_CR1 = 0;
+  REGISTER_UART1_CR3 &= ~_UART1_CR3_STOP_MASK;
+  
+  // The BRR2 must be written first. It gets the bits 15:12 and 3:0 of the
+  // divider and BRR1 the bits 11:4.
+  REGISTER_UART1_BRR2 = (uint8_t)(((divider >> 8) & 0xF0) | (divider & 0x0F));
+  REGISTER_UART1_BRR1 = (uint8_t)(divider >> 4);
+  
+  // Enable the transmitter, the receiver and the receive interrupt. The
+  // transmit interrupt is enabled only when there are bytes to send.
+  REGISTER_UART1_CR2 = UART1_CR2_TEN | UART1_CR2_REN | UART1_CR2_RIEN;
+}
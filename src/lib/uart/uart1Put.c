@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   uart1Put.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <uart.h>
+
+uint8_t _uart1Put(_Uart1State* state, const uint8_t* data, uint8_t size) {
+  uint8_t count = 0;
+  while (count < size
+         && (uint8_t)(state->tx_tail - state->tx_head) < UART1_TX_BUFFER_SIZE) {
+    state->tx[state->tx_tail & _UART1_TX_MASK] = data[count];
+    ++(state->tx_tail);
+    ++count;
+  }
+  // Let the interrupt send the bytes
+  if (count > 0) {
+    registerSet(REGISTER_UART1_CR2, UART1_CR2_TIEN);
+  }
+  return count;
+}
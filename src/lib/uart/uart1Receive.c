@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   uart1Receive.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <uart.h>
+
+void _uart1Receive(_Uart1State* state) {
+  // Reading the SR and then the DR clears both the RXNE and the overrun flags
+  uint8_t sr = REGISTER_UART1_SR;
+  uint8_t data = REGISTER_UART1_DR;
+  if (sr & UART1_SR_OR) {
+    ++(state->rx_dropped);
+  }
+  if ((uint8_t)(state->rx_tail - state->rx_head) < UART1_RX_BUFFER_SIZE) {
+    state->rx[state->rx_tail & _UART1_RX_MASK] = data;
+    ++(state->rx_tail);
+  } else {
+    ++(state->rx_dropped);
+  }
+}
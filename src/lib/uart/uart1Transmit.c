@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+/*
+ * File:   uart1Transmit.c
+ * Author: Nikolaos Apostolakos <nikoapos@gmail.com>
+ */
+
+#include <uart.h>
+
+void _uart1Transmit(_Uart1State* state) {
+  if (state->tx_head != state->tx_tail) {
+    REGISTER_UART1_DR = state->tx[state->tx_head & _UART1_TX_MASK];
+    ++(state->tx_head);
+  } else {
+    // Nothing more to send, so we stop the interrupt until the next put
+    REGISTER_UART1_CR2 &= ~UART1_CR2_TIEN;
+  }
+}
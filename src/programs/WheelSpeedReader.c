@@ -29,6 +29,20 @@
  * turn, the related counter is increased twice as the number of the encoder
  * disc cuts. These counters can be accessed via the I2C registers 0x01-0x04.
  * 
+ * By default the counters are updated by the port external interrupt, which is
+ * triggered on both edges of the input pins, so the CPU can sleep between the
+ * edges. Setting INTERRUPT_COUNTING to 0 switches back to constantly polling
+ * the input pins from the main loop. In both cases the whole port is read once
+ * and compared with the previous state, and every pin adds its bit of the
+ * result to its counter without branching, so the counting takes the same time
+ * no matter how many pins changed.
+ * 
+ * If the photo-interrupter signals bounce at the transitions, setting
+ * DEBOUNCE_SAMPLES to 2-8 counts only the levels which last that many ms. The
+ * port is then sampled every 1 ms from the TIM4 (see debounce.h) instead of
+ * being counted in the port interrupt or the main loop, so the counts cannot go
+ * higher than 1000 / DEBOUNCE_SAMPLES per second.
+ * 
  * The controller uses the counters to compute the number of encoder disc cuts
  * per second. The frequency this computation is performed can be controlled
  * for each wheel individually via the registers 0xA1-0xA4. These registers can
@@ -37,7 +51,55 @@
  * wheels. The longer the period the more accurate the measurement. The shorter
  * the period, more frequent updates. For example, if the wheel turns very slow
  * (once per second) this period should be significantly increased. The measured
- * frequency can be accessed via the I2C registers 0x11-0x14.
+ * frequency can be accessed via the I2C registers 0x31-0x34, as an unsigned
+ * Q16.16 fixed point number (the value divided by 65536 gives the counts/sec).
+ * The computation uses a precomputed reciprocal of the period, so no division
+ * or floating point arithmetic is done in the interrupt. Setting FLOAT_SPEED to
+ * 1 also exposes the frequency as a float via the I2C registers 0x11-0x14, for
+ * compatibility with older hosts, at the cost of linking the float library.
+ * Every wheel has its own software timer for the measurements, and the TIM4
+ * runs tickless, so it interrupts only when a measurement is due (or every 2ms
+ * for longer periods).
+ * 
+ * At low speeds the counting window gives very little resolution, so the period
+ * between the edges is also measured in hardware, using the TIM2 input capture.
+ * The STM8S103 has only three TIM2 channels, so this is done for the wheels
+ * 1-3, whose photo-interrupter signals must also be connected to the TIM2
+ * capture pins (D4, D3 and A3 respectively). The time between two rising edges
+ * is measured in ticks of 16us and can be accessed via the I2C registers
+ * 0x21-0x23. If no rising edge occurs for more than ~1s the value 0xFFFF is
+ * reported. Setting PERIOD_CAPTURE to 0 disables this measurement.
+ * 
+ * All the times are derived from the 16 MHz HSI, which is accurate to about
+ * 1%. Setting HSE_CLOCK to 1 runs the controller from a 16 MHz crystal on the
+ * pins A1 and A2 instead, so the speeds are as accurate as the crystal. If the
+ * crystal does not start the HSI is kept, and if it fails later the clock
+ * security system switches back to the HSI.
+ * 
+ * Without a crystal, setting HSI_CALIBRATION to 1 trims the HSI at startup
+ * against a 1 Hz reference (for example a GPS PPS signal) on the pin C7, which
+ * brings the error down to the trimming step of the HSI. The C7 is the TIM1
+ * capture input only when the AFR0 bit of the option byte OPT2 is set, which
+ * must be done once when the controller is programmed (for example by writing
+ * the option bytes with the stm8flash). Without it, or if there is no
+ * reference, the factory trimming is kept (the latter after a delay of about 4
+ * seconds). The AFR0 bit also moves the TIM2_CH1 from the D4 to the C5, which
+ * is the input of the wheel 3, so the capture 1 would measure the wheel 3
+ * instead of the wheel 1. For this reason the HSI_CALIBRATION cannot be combined
+ * with the PERIOD_CAPTURE, and the AFR0 bit must be left unset on controllers
+ * which use the PERIOD_CAPTURE.
+ * The selected trimming value and the remaining error can be accessed via the
+ * I2C registers 0x41-0x42.
+ * 
+ * Setting SPI_TRANSPORT to 1 serves the same registers over the SPI instead of
+ * the I2C (see spi_slave.h), so the master can poll them faster. The SPI uses
+ * the pins C5, C6, C7 and A3, so the photo-interrupters move to the pins D4,
+ * D3, D2 and D5 (wheels 1-4). The wheels 1-2 are then connected directly to
+ * their TIM2 capture pins, but the A3 is the NSS, so the wheel 3 has no edge
+ * period measurement and the register 0x23 is not available. The edges
+ * interrupt the SPI, so the master must leave enough time between the bytes
+ * for both interrupts. The AFR0 option bit moves the SPI away from the C5-C7,
+ * so the SPI_TRANSPORT cannot be combined with the HSI_CALIBRATION either.
  * 
  * I2C registers:
  * 
@@ -45,40 +107,134 @@
  * - 0x02 (uint16_t) : Counter 2
  * - 0x03 (uint16_t) : Counter 3
  * - 0x04 (uint16_t) : Counter 4
- * - 0x11 (float 4 byte) : Counter 1 speed (in counts/sec)
- * - 0x12 (float 4 byte) : Counter 2 speed (in counts/sec)
- * - 0x13 (float 4 byte) : Counter 3 speed (in counts/sec)
- * - 0x14 (float 4 byte) : Counter 4 speed (in counts/sec)
+ * - 0x11 (float 4 byte) : Counter 1 speed (in counts/sec, if FLOAT_SPEED)
+ * - 0x12 (float 4 byte) : Counter 2 speed (in counts/sec, if FLOAT_SPEED)
+ * - 0x13 (float 4 byte) : Counter 3 speed (in counts/sec, if FLOAT_SPEED)
+ * - 0x14 (float 4 byte) : Counter 4 speed (in counts/sec, if FLOAT_SPEED)
+ * - 0x21 (uint16_t) : Edge period 1 (in 16us ticks)
+ * - 0x22 (uint16_t) : Edge period 2 (in 16us ticks)
+ * - 0x23 (uint16_t) : Edge period 3 (in 16us ticks)
+ * - 0x31 (uint32_t Q16.16) : Counter 1 speed (in counts/sec)
+ * - 0x32 (uint32_t Q16.16) : Counter 2 speed (in counts/sec)
+ * - 0x33 (uint32_t Q16.16) : Counter 3 speed (in counts/sec)
+ * - 0x34 (uint32_t Q16.16) : Counter 4 speed (in counts/sec)
+ * - 0x41 (int8_t) : HSI trimming value (if HSI_CALIBRATION)
+ * - 0x42 (int32_t) : Remaining HSI error (in ppm, if HSI_CALIBRATION)
  * - 0xA1 (uint16_t) : Speed measure period 1
  * - 0xA2 (uint16_t) : Speed measure period 2
  * - 0xA3 (uint16_t) : Speed measure period 3
  * - 0xA4 (uint16_t) : Speed measure period 4
+ * 
+ * Only the counters and the speed measure periods can be written by the master.
+ * 
+ * The registers can be accessed in bursts: when the bytes of a register are
+ * used up the transaction continues with the next register of the list above.
+ * For example, reading 8 bytes from 0x01 returns all four counters and reading
+ * 16 bytes from 0x31 returns all four speeds.
  */
 
 #include <stdbool.h>
 #include <clk.h>
+#include <clk_trim.h>
+#include <debounce.h>
 #include <i2c.h>
+#include <spi_slave.h>
 #include <gpio.h>
 #include <itc.h>
-#include <tim4.h>
+#include <tim2.h>
+#include <timer.h>
 
 // The slave I2C address the micro controller will listen to
 #define I2C_ADDRESS 0x55
 
+// Set to 1 to serve the registers over the SPI, or to 0 to serve them over the
+// I2C
+#define SPI_TRANSPORT 0
+
 // The pins where each photo-interrupter is connected
+#if SPI_TRANSPORT
+// The C5-C7 are used by the SPI
+#define PORT_IN D
+#define PIN_IN_1 4
+#define PIN_IN_2 3
+#define PIN_IN_3 2
+#define PIN_IN_4 5
+#define IRQ_PORT_IN ITC_IRQ_PORTD
+#else
 #define PORT_IN C
 #define PIN_IN_1 3
 #define PIN_IN_2 4
 #define PIN_IN_3 5
 #define PIN_IN_4 6
+#define IRQ_PORT_IN ITC_IRQ_PORTC
+#endif
+
+// Set to 1 to count the edges in the port external interrupt and sleep in the
+// main loop, or to 0 to poll the input pins constantly from the main loop
+#define INTERRUPT_COUNTING 1
+
+// Set to the number of 1 ms samples (2-8) a level of the input pins must last
+// to be counted, or to 0 to count every edge. It needs INTERRUPT_COUNTING 0.
+#define DEBOUNCE_SAMPLES 0
+#if DEBOUNCE_SAMPLES && INTERRUPT_COUNTING
+#error "The DEBOUNCE_SAMPLES replace the INTERRUPT_COUNTING"
+#endif
+
+// Set to 1 to measure the period between the edges of the wheels 1-3 with the
+// TIM2 input capture, or to 0 to disable it
+#define PERIOD_CAPTURE 1
+
+// The TIM2 capture channels in use. With the SPI the A3 is the NSS, so the
+// channel 3 is not available.
+#if SPI_TRANSPORT
+#define CAPTURE_CHANNELS 2
+#else
+#define CAPTURE_CHANNELS 3
+#endif
+
+// Set to 1 to also expose the speeds as floats (requires the float library)
+#define FLOAT_SPEED 0
+
+// Set to 1 to run from a 16 MHz crystal, or to 0 to run from the HSI
+#define HSE_CLOCK 0
+
+// Set to 1 to trim the HSI against a 1 Hz reference on the pin C7 (requires the
+// AFR0 option bit)
+#define HSI_CALIBRATION 0
+#if HSI_CALIBRATION && PERIOD_CAPTURE
+#error "The AFR0 option bit of the HSI_CALIBRATION moves the TIM2_CH1 of the PERIOD_CAPTURE to the C5"
+#endif
+#if HSI_CALIBRATION && SPI_TRANSPORT
+#error "The AFR0 option bit of the HSI_CALIBRATION moves the SPI away from the C5-C7"
+#endif
+
+// The peripherals which are clocked, all the others are gated
+#if SPI_TRANSPORT
+#define TRANSPORT_PERIPHERAL CLK_PERIPHERAL_SPI
+#else
+#define TRANSPORT_PERIPHERAL CLK_PERIPHERAL_I2C
+#endif
+#if PERIOD_CAPTURE
+#define USED_PERIPHERALS (TRANSPORT_PERIPHERAL | CLK_PERIPHERAL_TIM4 | CLK_PERIPHERAL_TIM2)
+#else
+#define USED_PERIPHERALS (TRANSPORT_PERIPHERAL | CLK_PERIPHERAL_TIM4)
+#endif
 
 typedef struct {
   uint16_t count; // The counter of the wheel
-  bool state; // The current state of the photo-interrupter
   uint16_t period; // The period in ms to perform a speed measurement
-  uint16_t last_meas_time; // The ms passed from the last measurement time
+  Timer timer; // The timer of the speed measurements
+  uint32_t speed; // The counter speed in counts/sec (Q16.16)
+#if FLOAT_SPEED
   float counts_speed; // The counter speed in counts/sec
+#endif
   uint16_t last_count; // The value of the counter during the last measurement
+  uint16_t reciprocal_period; // The period the reciprocal was computed for
+  uint32_t reciprocal; // The 1000 * 2^16 / period, to get Q16.16 counts/sec
+  uint16_t max_counts; // The maximum counts which do not overflow the speed
+  uint16_t edge_period; // The TIM2 ticks between the last two rising edges
+  uint16_t last_capture; // The TIM2 timestamp of the last rising edge
+  uint8_t capture_age; // The TIM2 overflows since the last rising edge (up to 3)
 } Wheel;
 
 Wheel wheel_1;
@@ -86,35 +242,148 @@ Wheel wheel_2;
 Wheel wheel_3;
 Wheel wheel_4;
 
-void updateWheelCounter(Wheel* wheel, bool new_state) {
-  if (new_state != wheel->state) {
-    wheel->count += 1;
-    wheel->state = new_state;
+// Defined after the main
+void updateReciprocal(Wheel* wheel);
+void startWheel(Wheel* wheel);
+
+// The state of the input port as it was seen during the last count
+uint8_t port_in_state;
+
+// The counter of the wheel connected to every pin of the input port. The pins
+// without a wheel point to a counter nobody reads, so all the pins are counted
+// the same way.
+uint16_t* pin_counters[8];
+uint16_t unused_pin_count;
+
+// Fills the pin_counters table with the wheel of every input pin
+void setupPinCounters() {
+  uint8_t pin;
+  
+  for (pin = 0; pin < 8; ++pin) {
+    pin_counters[pin] = &unused_pin_count;
+  }
+  pin_counters[PIN_IN_1] = &wheel_1.count;
+  pin_counters[PIN_IN_2] = &wheel_2.count;
+  pin_counters[PIN_IN_3] = &wheel_3.count;
+  pin_counters[PIN_IN_4] = &wheel_4.count;
+}
+
+// Increases the counter of every pin in the edges mask. Each counter adds its
+// bit, so there are no branches and the time is the same for any number of
+// edges.
+void addEdges(uint8_t edges) {
+  uint16_t** counter = pin_counters;
+  
+  do {
+    **counter += edges & 1;
+    edges >>= 1;
+    ++counter;
+  } while (counter != pin_counters + 8);
+}
+
+// Reads the input port once and counts the pins which changed since the last
+// time, which are found with a single XOR
+void countEdges() {
+  uint8_t new_state = gpioReadPort(PORT_IN);
+  uint8_t edges = new_state ^ port_in_state;
+  
+  port_in_state = new_state;
+#if INTERRUPT_COUNTING
+  // This is the interrupt with the highest priority, so nothing else writes
+  // the counters in the middle of the additions
+  addEdges(edges);
+#else
+  // The main loop is interrupted by the TIM4 and the I2C, which reset and write
+  // the counters, so the additions must be atomic. The interrupts are disabled
+  // only when there is something to count, so most of the loops leave them on.
+  if (edges) {
+    __critical {
+      addEdges(edges);
+    }
   }
+#endif
+}
+
+#if DEBOUNCE_SAMPLES
+// The debouncer of the input port
+Debouncer port_in_debouncer;
+
+// Called by the debouncer with the pins which changed their debounced level
+void countDebouncedEdges(uint8_t rising, uint8_t falling) {
+  addEdges(rising | falling);
+}
+#endif
+
+#if HSI_CALIBRATION
+// The result of the HSI calibration
+HsiTrimResult hsi_trim;
+
+// Trims the HSI against the 1 Hz reference. With the TIM1 prescaler 256 the
+// reference period is 62500 ticks at 16 MHz.
+void calibrateHsi() {
+  // Without the AFR0 remapping the C7 is not connected to the TIM1
+  if (!clkTim1ReferenceAvailable()) {
+    return;
+  }
+  clkEnablePeripherals(CLK_PERIPHERAL_TIM1);
+  clkStartTim1Reference(256);
+  clkCalibrateHsi(clkMeasureTim1Reference, 62500, &hsi_trim);
+  clkStopTim1Reference();
+  clkDisablePeripherals(CLK_PERIPHERAL_TIM1);
+}
+#endif
+
+#if HSE_CLOCK
+// Switches the master clock to the crystal. If it does not start in time, the
+// switch is aborted and we continue with the HSI.
+void switchToHse() {
+  uint16_t timeout;
+  clkStartSwitch(HSE);
+  for (timeout = 0xFFFF; timeout > 0 && clkIsSwitching(); --timeout);
+  if (clkIsSwitching()) {
+    clkAbortSwitch();
+  } else {
+    clkEnableCss();
+  }
+}
+
+// Called when the crystal fails. The clock is switched to the HSI divided by
+// 8, so we remove the divider to keep the 16 MHz all the timings are based on.
+void hseFailure() {
+  clkSetHsiDivider(1);
 }
 
+// Setup the clock controller interruption for the clock security system
+clkInterruptHandler(0, hseFailure)
+#endif
+
 // The main method
 int main() {
   
   // Set the f_master to 16 MHz
   clkSetHsiDivider(1);
   
-  // Set the TIM4 timer to create an interrupt every 1ms
-  // We run at 16 Mz and we set the prescaler to 128, so the frequency of the
-  // TIM4 is 125 kHz
-  tim4SetPrescaler(TIM4_PRESCALER_128);
-  // We want 1 ms period, so the timer should overflow when it reaches 124
-  tim4SetPeriod(124);
+  // Clock only the peripherals we use
+  clkEnableOnlyPeripherals(USED_PERIPHERALS);
+  
+#if HSI_CALIBRATION
+  calibrateHsi();
+#endif
+  
+#if HSE_CLOCK
+  switchToHse();
+#endif
   
-  // Set the period of all the wheels to 100ms (the default)
-  wheel_1.period = 100;
-  wheel_2.period = 100;
-  wheel_3.period = 100;
-  wheel_4.period = 100;
+  // Use the TIM4 for the software timers, interrupting only when a timer
+  // expires
+  timerInitialize(16, TIMER_TICKLESS);
   
-  // Enable the TIM4 interrupts and start it
-  tim4EnableInterrupt();
-  tim4Start();
+  // Set the period of all the wheels to 100ms (the default) and start their
+  // measurement timers
+  startWheel(&wheel_1);
+  startWheel(&wheel_2);
+  startWheel(&wheel_3);
+  startWheel(&wheel_4);
   
   // Reset all pins to use the minimum power
   gpioSetAllPortsInputPullUpNoInt();
@@ -125,104 +394,294 @@ int main() {
   gpioSetAsInput(PORT_IN, PIN_IN_3);
   gpioSetAsInput(PORT_IN, PIN_IN_4);
   
-  // Initialize the I2C peripheral
-  i2cInitialize(I2C_ADDRESS, 16);
+  // Map the input pins to the wheel counters and take the initial snapshot of
+  // the port
+  setupPinCounters();
+  port_in_state = gpioReadPort(PORT_IN);
+  
+#if DEBOUNCE_SAMPLES
+  // Sample the input port every 1 ms
+  debounceStart(&port_in_debouncer, PORT_IN, DEBOUNCE_SAMPLES, 1, countDebouncedEdges);
+#endif
+  
+#if INTERRUPT_COUNTING
+  // Enable the external interrupts of the input pins on both edges
+  gpioEnableInterrupt(PORT_IN, PIN_IN_1);
+  gpioEnableInterrupt(PORT_IN, PIN_IN_2);
+  gpioEnableInterrupt(PORT_IN, PIN_IN_3);
+  gpioEnableInterrupt(PORT_IN, PIN_IN_4);
+  itcSetPortSensitivity(PORT_IN, ITC_EXT_RISE_FALL);
+#endif
+  
+#if PERIOD_CAPTURE
+  // Let the TIM2 count freely with a prescaler of 256, so every tick is 16us
+  // and it overflows every ~1s
+  tim2SetPrescaler(TIM2_PRESCALER_256);
+  tim2SetPeriod(0xFFFF);
+  
+  // Capture the rising edges. The filter ignores glitches shorter than 4us.
+  tim2SetupCapture(1, TIM2_ICF_MASTER_8_N8, TIM2_CAPTURE_RISING);
+  tim2SetupCapture(2, TIM2_ICF_MASTER_8_N8, TIM2_CAPTURE_RISING);
+  tim2EnableCaptureInterrupt(1);
+  tim2EnableCaptureInterrupt(2);
+#if CAPTURE_CHANNELS > 2
+  tim2SetupCapture(3, TIM2_ICF_MASTER_8_N8, TIM2_CAPTURE_RISING);
+  tim2EnableCaptureInterrupt(3);
+#endif
+  tim2EnableInterrupt();
+  tim2Start();
+#endif
+  
+#if SPI_TRANSPORT
+  // Initialize the SPI as slave, in the mode 0
+  spiInitializeSlave(SPI_MODE_0);
+#else
+  // Initialize the I2C peripheral in fast mode, so the master can poll at
+  // 400 kbit/s
+  i2cInitializeMode(I2C_ADDRESS, 16, FAST);
+#endif
   
   // Enable the interrupts
-  itcSetPriority(ITC_IRQ_I2C, 3); // I2C must have the highest priority
+#if INTERRUPT_COUNTING
+  // The edges must have the highest priority, so their latency does not depend
+  // on the other interrupts. The I2C can wait, as it stretches the clock. The
+  // TIM4 has the same priority as the I2C, so the I2C never interrupts it in
+  // the middle of updating a speed and the master always reads whole values.
+  // The same holds for the SPI, whose end of frame interrupt (Port A) must
+  // have its priority.
+  itcSetPriority(IRQ_PORT_IN, 3);
+#if SPI_TRANSPORT
+  itcSetPriority(ITC_IRQ_SPI, 2);
+  itcSetPriority(ITC_IRQ_PORTA, 2);
+#else
+  itcSetPriority(ITC_IRQ_I2C, 2);
+#endif
   itcSetPriority(ITC_IRQ_TIM4_UPD_OVF, 2);
+#else
+  // I2C (or the SPI and its Port A) must have the highest priority. The TIM4
+  // has the same priority, so the I2C never interrupts it in the middle of
+  // updating a speed.
+#if SPI_TRANSPORT
+  itcSetPriority(ITC_IRQ_SPI, 3);
+  itcSetPriority(ITC_IRQ_PORTA, 3);
+#else
+  itcSetPriority(ITC_IRQ_I2C, 3);
+#endif
+  itcSetPriority(ITC_IRQ_TIM4_UPD_OVF, 3);
+#endif
+#if PERIOD_CAPTURE
+  // The timestamps are kept by the hardware, so the capture can wait
+  itcSetPriority(ITC_IRQ_TIM2_CPT_CMP, 1);
+  itcSetPriority(ITC_IRQ_TIM2_UPD_OVF, 1);
+#endif
   enableInterrupts();
   
+#if INTERRUPT_COUNTING || DEBOUNCE_SAMPLES
+  // The counters are updated by the interrupts, so we just sleep
+  while(1) {
+    waitForInterrupt();
+  }
+#else
   // Start an infinite loop which updates the counters constantly
   while(1) {
-    // Update the counters
-    updateWheelCounter(&wheel_1, gpioReadInput(PORT_IN, PIN_IN_1));
-    updateWheelCounter(&wheel_2, gpioReadInput(PORT_IN, PIN_IN_2));
-    updateWheelCounter(&wheel_3, gpioReadInput(PORT_IN, PIN_IN_3));
-    updateWheelCounter(&wheel_4, gpioReadInput(PORT_IN, PIN_IN_4));
+    countEdges();
+  }
+#endif
+  
+}
+
+// The I2C register each internal variable is exposed to. The first 4 bits of
+// the ID indicate the variable and the last 4 bits the wheel. The master is
+// allowed to write only the counters and the measurement periods.
+const RegmapEntry registers[] = {
+  regmapRegister(0x01, wheel_1.count, REGMAP_READ_WRITE),
+  regmapRegister(0x02, wheel_2.count, REGMAP_READ_WRITE),
+  regmapRegister(0x03, wheel_3.count, REGMAP_READ_WRITE),
+  regmapRegister(0x04, wheel_4.count, REGMAP_READ_WRITE),
+#if FLOAT_SPEED
+  regmapRegister(0x11, wheel_1.counts_speed, REGMAP_READ_ONLY),
+  regmapRegister(0x12, wheel_2.counts_speed, REGMAP_READ_ONLY),
+  regmapRegister(0x13, wheel_3.counts_speed, REGMAP_READ_ONLY),
+  regmapRegister(0x14, wheel_4.counts_speed, REGMAP_READ_ONLY),
+#endif
+#if PERIOD_CAPTURE
+  // There is no capture channel for the fourth wheel
+  regmapRegister(0x21, wheel_1.edge_period, REGMAP_READ_ONLY),
+  regmapRegister(0x22, wheel_2.edge_period, REGMAP_READ_ONLY),
+#if CAPTURE_CHANNELS > 2
+  regmapRegister(0x23, wheel_3.edge_period, REGMAP_READ_ONLY),
+#endif
+#endif
+  regmapRegister(0x31, wheel_1.speed, REGMAP_READ_ONLY),
+  regmapRegister(0x32, wheel_2.speed, REGMAP_READ_ONLY),
+  regmapRegister(0x33, wheel_3.speed, REGMAP_READ_ONLY),
+  regmapRegister(0x34, wheel_4.speed, REGMAP_READ_ONLY),
+#if HSI_CALIBRATION
+  regmapRegister(0x41, hsi_trim.trim, REGMAP_READ_ONLY),
+  regmapRegister(0x42, hsi_trim.error_ppm, REGMAP_READ_ONLY),
+#endif
+  regmapRegister(0xA1, wheel_1.period, REGMAP_READ_WRITE),
+  regmapRegister(0xA2, wheel_2.period, REGMAP_READ_WRITE),
+  regmapRegister(0xA3, wheel_3.period, REGMAP_READ_WRITE),
+  regmapRegister(0xA4, wheel_4.period, REGMAP_READ_WRITE)
+};
+
+// Setup the I2C (or SPI) interruption to expose the registers. The values are
+// read and written via a buffer big enough for the speeds, so the master never
+// gets half-old half-new values.
+#if SPI_TRANSPORT
+spiRegisterMapSlaveInterruptHandler(registers, 4)
+#else
+i2cRegisterMapSlaveInterruptHandler(registers, 4)
+#endif
+
+
+// Computes the reciprocal of the measurement period, so the speed can be
+// computed with a single multiplication. This is done only when the period is
+// changed, so the division is not in the path of every measurement.
+void updateReciprocal(Wheel* wheel) {
+  // A period of 0 means that we measure every 1ms, as with a period of 1
+  uint16_t period = wheel->period ? wheel->period : 1;
+  
+  wheel->reciprocal = (1000UL << 16) / period;
+  // The speed is stored in 32 bits, so we saturate it if the counts are so many
+  // that the multiplication would overflow
+  if (wheel->reciprocal > 0xFFFFUL) {
+    wheel->max_counts = 0xFFFFFFFFUL / wheel->reciprocal;
+  } else {
+    wheel->max_counts = 0xFFFF;
+  }
+  wheel->reciprocal_period = wheel->period;
+}
+
+// Called by the timer of the wheel at the end of every measurement period
+void measureSpeed(void* context) {
+  Wheel* wheel = context;
+  uint16_t count;
+  uint16_t counts;
+  uint16_t period;
+  
+  // The counter is read once, as the edges can be counted by a higher priority
+  // interrupt. An edge counted after the read belongs to the next period.
+  count = wheel->count;
+  
+  // Check if we have an overflow of the wheel counter. In this case we don't do
+  // a measurement and we just restart the measurement period.
+  if (wheel->last_count <= count) {
+    // Compute the counts per second, with the reciprocal of the period which
+    // just ended
+    counts = count - wheel->last_count;
+    if (counts > wheel->max_counts) {
+      wheel->speed = 0xFFFFFFFFUL;
+    } else {
+      wheel->speed = counts * wheel->reciprocal;
+    }
+#if FLOAT_SPEED
+    wheel->counts_speed = wheel->speed / 65536.;
+#endif
   }
+  wheel->last_count = count;
   
+  // Check if the period was changed by the master, so the next measurement
+  // period has the new length. A period of 0 means that we measure every 1ms.
+  if (wheel->period != wheel->reciprocal_period) {
+    updateReciprocal(wheel);
+    period = wheel->period ? wheel->period : 1;
+    timerStart(&wheel->timer, period, period);
+  }
 }
 
-// This method controls the I2C register address each internal variable is
-// exposed to
-uint8_t* getMemoryPointer(uint8_t id, uint8_t* size) {
-  // The first 4 bits of the address indicate the variable
-  uint8_t var_id = id & 0xF0;
-  // The last 4 bits of the address indicate the wheel
-  uint8_t wheel_id = id & 0x0F;
+// Sets the default measurement period of a wheel and starts its timer
+void startWheel(Wheel* wheel) {
+  wheel->period = 100;
+  updateReciprocal(wheel);
+  timerSetup(&wheel->timer, measureSpeed, wheel);
+  timerStart(&wheel->timer, wheel->period, wheel->period);
+}
+
+// Setup the TIM4 interruption for the software timers
+timerInterruptHandler()
+
+#if INTERRUPT_COUNTING
+// Called every time one of the input pins changes state
+void countEdgesEvent() __interrupt(IRQ_PORT_IN) {
+  countEdges();
+}
+#endif
+
+#if PERIOD_CAPTURE
+// Called with the TIM2 timestamp of every rising edge of the wheels 1-3
+void measureEdgePeriod(uint8_t channel, uint16_t timestamp) {
   Wheel* wheel;
+  uint8_t age;
+  uint16_t now;
   
-  switch (wheel_id) {
-    case 0x01:
+  switch (channel) {
+    case 1:
       wheel = &wheel_1;
       break;
-    case 0x02:
+    case 2:
       wheel = &wheel_2;
       break;
-    case 0x03:
+    default:
       wheel = &wheel_3;
       break;
-    case 0x04:
-      wheel = &wheel_4;
-      break;
-    default:
-      return 0;
   }
   
-  switch (var_id) {
-    case 0x00:
-      *size = 2;
-      return &(wheel->count);
-    case 0x10:
-      *size = 4;
-      return &(wheel->counts_speed);
-    case 0xA0:
-      *size = 2;
-      return &(wheel->period);
+  // The overflows are counted by the update interrupt, which has the lower
+  // vector and is served first when both are pending, so the age can include
+  // an overflow which came after this capture, or miss one which came before
+  // it and is still pending. The capture is placed relative to the overflow
+  // with the counter, which has wrapped since the capture if it is now behind
+  // the timestamp (this interrupt runs much faster than half a period).
+  age = wheel->capture_age;
+  tim2ReadCounter(now);
+  if (REGISTER_TIM2_SR1 & TIM2_SR1_UIF) {
+    // The pending overflow is not counted yet. The counter is read again, as
+    // the overflow might have come after the first read.
+    tim2ReadCounter(now);
+    if (now >= timestamp) {
+      ++age;
+    }
+  } else if (now < timestamp && age > 0) {
+    // The overflow after the capture is already counted
+    --age;
   }
   
-  return 0;
+  // The subtraction handles a single overflow of the timer. If the timer
+  // overflowed more times, the period does not fit and we saturate it.
+  if (age > 1 || (age == 1 && timestamp >= wheel->last_capture)) {
+    wheel->edge_period = 0xFFFF;
+  } else {
+    wheel->edge_period = timestamp - wheel->last_capture;
+  }
+  
+  wheel->last_capture = timestamp;
+  wheel->capture_age = 0;
 }
 
-// Setup the I2C interruption to expose the variables in the memory
-i2cMemorySlaveIterruptHandler(getMemoryPointer)
-
+// Setup the TIM2 capture interruption to measure the edge periods
+tim2CaptureInterruptHandler(measureEdgePeriod)
 
-void measureSpeed(Wheel* wheel) {
-  // Check if we have an overflow of the wheel counter
-  if (wheel->last_count > wheel->count) {
-    // We don't do a measurement a this time and we setup the variables to
-    // restart the measurement period
-    wheel->last_count = wheel->count;
-    wheel->last_meas_time = 0;
-    return;
+// Counts an overflow since the last capture of a wheel. The age saturates at 3,
+// so the capture can still take back an overflow which came after it.
+void ageCapture(Wheel* wheel) {
+  if (wheel->capture_age < 3) {
+    wheel->capture_age += 1;
   }
-  
-  // Increase the time from last measurement by 1ms and check if we need to
-  // perform a measurement
-  wheel->last_meas_time += 1;
-  if (wheel->last_meas_time < wheel->period) {
-    return;
+  // If the wheel stopped we report it as soon as we know the period is too long
+  if (wheel->capture_age >= 2) {
+    wheel->edge_period = 0xFFFF;
   }
-  
-  // Compute the counts per second
-  wheel->counts_speed = 1000. * (wheel->count - wheel->last_count) / wheel->period;
-  
-  // Restart the measurement period
-  wheel->last_count = wheel->count;
-  wheel->last_meas_time = 0;
-  
 }
 
-// Called every time the TIM4 overflows, aka every 1ms
-void measureSpeedEvent() __interrupt(ITC_IRQ_TIM4_UPD_OVF) {
-  // First we clear the interrupt flag
-  tim4ClearUpdateInterruptFlag();
-  
-  // Measure the speeds of all wheels
-  measureSpeed(&wheel_1);
-  measureSpeed(&wheel_2);
-  measureSpeed(&wheel_3);
-  measureSpeed(&wheel_4);
-}
\ No newline at end of file
+// Called every time the TIM2 overflows, aka every ~1s
+void captureOverflowEvent() __interrupt(ITC_IRQ_TIM2_UPD_OVF) {
+  tim2ClearUpdateInterruptFlag();
+  ageCapture(&wheel_1);
+  ageCapture(&wheel_2);
+#if CAPTURE_CHANNELS > 2
+  ageCapture(&wheel_3);
+#endif
+}
+#endif
\ No newline at end of file
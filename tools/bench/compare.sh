@@ -0,0 +1,29 @@
+#!/bin/sh
+# Compares the benchmark results with the baseline and fails if any
+# measurement takes more cycles than the baseline plus the tolerance, or if
+# there is no baseline at all.
+# Usage: compare.sh <baseline> <results> <tolerance in percent>
+
+baseline="$1"
+results="$2"
+tolerance="$3"
+
+if [ ! -f "$baseline" ]; then
+  cat "$results"
+  echo "No baseline in $baseline, run \"make bench-baseline\" and commit it" >&2
+  exit 1
+fi
+
+awk -v tolerance="$tolerance" '
+  NR == FNR { base[$1] = $2; next }
+  !($1 in base) { printf "%-40s %6d (new)\n", $1, $2; next }
+  {
+    status = ""
+    if ($2 * 100 > base[$1] * (100 + tolerance)) {
+      status = "REGRESSION"
+      failed = 1
+    }
+    printf "%-40s %6d %+6d %s\n", $1, $2, $2 - base[$1], status
+  }
+  END { exit failed }
+' "$baseline" "$results"
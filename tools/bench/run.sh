@@ -0,0 +1,22 @@
+#!/bin/sh
+# Runs the benchmarks in the sstm8 simulator and prints their results, one
+# "<benchmark>.<measurement> <cycles>" line per measurement. The UART1 output
+# of every benchmark is kept next to its .ihx file.
+# Usage: run.sh "<simulator command>" <ihx files>
+
+simulator="$1"
+shift
+
+for ihx in "$@"; do
+  name=$(basename "$ihx" .ihx)
+  out="${ihx%.ihx}.out"
+  rm -f "$out"
+  # The benchmark stops the simulation with a break instruction, after which
+  # the simulator reads the quit command
+  printf 'run\nquit\n' | $simulator -S out="$out" "$ihx" > /dev/null || exit 1
+  if [ ! -s "$out" ]; then
+    echo "$ihx: no results, check the simulator flags" >&2
+    exit 1
+  fi
+  sed "s/^/$name./" "$out"
+done
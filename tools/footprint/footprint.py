@@ -0,0 +1,315 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2018 Nikolaos Apostolakos <nikoapos@gmail.com>
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+"""
+Reports the flash and RAM footprint of the programs built by SDCC and checks
+it against the device and the budget file.
+
+For every program the .map file of the linker gives the size of every area and
+the address of every symbol. The size of a symbol is the distance to the next
+symbol of its area. The .asm file of the compiler gives the source file every
+function comes from (SDCC writes the source lines as comments after the label
+of every function) and the stack
+frame of its local variables (the "sub sp, #n" of its prologue). The frame does
+not include the return addresses and the frames of the called functions.
+
+The driver functions are linked from the library, so their .asm files are
+next to the .rel files of the library directory (--library), one per function.
+Functions without an .asm file are matched to the src/lib/<header>/<name>.c
+file of the same name. The code of the library is also summed per header.
+
+Usage: footprint.py [--model MODEL] [--budget FILE] [--library DIR] [--verbose]
+                    [--write-budget MARGIN] MAP_FILE...
+
+The budget file has one limit per line, in the form
+  <program> <item> <bytes>
+where the program is the name of the .map file without extension (or * for
+all programs) and the item is "flash", "ram" or the name of a function (for
+its code size). Lines starting with # are comments.
+
+With --write-budget the limits of every program (its flash and the code of
+every function) are measured and written to the budget file instead of being
+checked, with MARGIN percent of headroom. The comments and the limits for all
+programs (*) are kept.
+"""
+
+import argparse
+import glob
+import math
+import os
+import re
+import sys
+
+# The flash and RAM sizes of the supported models
+DEVICES = {
+    'STM8S103F2': (4096, 1024),
+    'STM8S103F3': (8192, 1024),
+}
+
+# The areas placed in RAM. All the other non-absolute areas are in flash.
+RAM_AREAS = ('DATA', 'INITIALIZED')
+CONST_AREAS = ('CONST', 'INITIALIZER')
+
+# The comment before the measured limits of the budget file, which are
+# replaced by --write-budget
+MEASURED_COMMENT = '# Measured by "make footprint-budget"'
+ABSOLUTE_AREAS = ('.  .ABS.', 'CABS', 'DABS')
+
+AREA_LINE = re.compile(r'^(\S+)\s+([0-9A-Fa-f]{8})\s+([0-9A-Fa-f]{8})\s+=\s+(\d+)\.\s+bytes')
+SYMBOL_LINE = re.compile(r'^\s+([0-9A-Fa-f]{8})\s+(\S+)')
+ASM_SOURCE_LINE = re.compile(r'^;\s+(\S+):\s+\d+:')
+ASM_LABEL_LINE = re.compile(r'^(_\w+):')
+ASM_FRAME_LINE = re.compile(r'^\s+sub\s+sp,\s+#(0x[0-9a-fA-F]+|\d+)')
+LIBRARY_SOURCE = re.compile(r'(?:^|/)src/lib/(\w+)/\w+\.c$')
+
+
+def parseMap(path):
+    """Returns a dictionary with the size of every area and a list with the
+    (area, symbol, size) of every symbol"""
+    areas = {}
+    symbols = []
+    area = None
+    area_symbols = []
+
+    def closeArea():
+        if area is None:
+            return
+        start, size = areas[area][1], areas[area][0]
+        ordered = sorted(area_symbols)
+        for i, (address, name) in enumerate(ordered):
+            end = ordered[i + 1][0] if i + 1 < len(ordered) else start + size
+            symbols.append((area, name, end - address))
+
+    with open(path) as f:
+        for line in f:
+            match = AREA_LINE.match(line)
+            if match:
+                closeArea()
+                area = match.group(1)
+                areas[area] = (int(match.group(3), 16), int(match.group(2), 16))
+                area_symbols = []
+                continue
+            match = SYMBOL_LINE.match(line)
+            if match and area is not None and area not in ABSOLUTE_AREAS:
+                address = int(match.group(1), 16)
+                name = match.group(2)
+                if name.startswith('_') and areas[area][0] > 0:
+                    area_symbols.append((address, name))
+    closeArea()
+    return dict((name, size) for name, (size, start) in areas.items()), symbols
+
+
+def parseAsm(path):
+    """Returns the source file and the stack frame of every function"""
+    sources = {}
+    frames = {}
+    function = None
+    if not os.path.exists(path):
+        return sources, frames
+    with open(path) as f:
+        for line in f:
+            # The first source line after the label of a function is in the
+            # file the function is defined in
+            match = ASM_SOURCE_LINE.match(line)
+            if match:
+                if function is not None and function not in sources:
+                    sources[function] = match.group(1)
+                continue
+            match = ASM_LABEL_LINE.match(line)
+            if match:
+                function = match.group(1)
+                continue
+            match = ASM_FRAME_LINE.match(line)
+            if match and function is not None and function not in frames:
+                frames[function] = int(match.group(1), 0)
+    return sources, frames
+
+
+def parseLibrary(directory):
+    """Returns the source file and the stack frame of every function of the
+    library, from the .asm files of its modules. Functions without an .asm
+    file get the library source file with their name (without the leading
+    underscore of the C name), if it exists."""
+    sources = {}
+    frames = {}
+    if directory is None:
+        return sources, frames
+    for path in sorted(glob.glob(os.path.join(directory, '**', '*.asm'), recursive=True)):
+        module_sources, module_frames = parseAsm(path)
+        sources.update(module_sources)
+        frames.update(module_frames)
+    root = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..')
+    for path in sorted(glob.glob(os.path.join(root, 'src', 'lib', '*', '*.c'))):
+        name = os.path.splitext(os.path.basename(path))[0]
+        relative = os.path.relpath(path, root)
+        # SDCC prefixes the C names with an underscore and the internal
+        # functions have one more
+        for symbol in ('_' + name, '__' + name):
+            sources.setdefault(symbol, relative)
+    return sources, frames
+
+
+def sourceGroup(source):
+    """Returns the header the code of a source file is reported under, which
+    is the source itself for the programs"""
+    match = LIBRARY_SOURCE.search(source)
+    if match:
+        return 'include/{}.h (library)'.format(match.group(1))
+    return source
+
+
+def readBudget(path):
+    budget = []
+    if path is None or not os.path.exists(path):
+        return budget
+    with open(path) as f:
+        for number, line in enumerate(f, 1):
+            line = line.strip()
+            if not line or line.startswith('#'):
+                continue
+            fields = line.split()
+            if len(fields) != 3:
+                sys.exit('{}:{}: expected "<program> <item> <bytes>"'.format(path, number))
+            budget.append((fields[0], fields[1], int(fields[2], 0)))
+    return budget
+
+
+def writeBudget(path, measured, margin):
+    """Writes the measured limits to the budget file, with the given margin
+    (in percent), keeping its comments and the limits for all the programs"""
+    kept = []
+    if os.path.exists(path):
+        with open(path) as f:
+            for line in f:
+                fields = line.split()
+                if line.startswith(MEASURED_COMMENT):
+                    break
+                if not fields or line.startswith('#') or fields[0] == '*':
+                    kept.append(line.rstrip('\n'))
+    while kept and not kept[-1].strip():
+        kept.pop()
+    with open(path, 'w') as f:
+        for line in kept:
+            f.write(line + '\n')
+        f.write('\n{} with {}% margin\n'.format(MEASURED_COMMENT, margin))
+        for program, item, value in measured:
+            f.write('{} {} {}\n'.format(program, item, int(math.ceil(value * (100 + margin) / 100.))))
+
+
+def report(map_path, device, budget, library, verbose, measured):
+    """Prints the footprint of a program and returns the number of violated
+    limits. The flash of the program and the code of its functions are added
+    to the measured list."""
+    program = os.path.splitext(os.path.basename(map_path))[0]
+    areas, symbols = parseMap(map_path)
+    sources, frames = parseAsm(os.path.splitext(map_path)[0] + '.asm')
+    # The functions of the program take precedence over the library ones
+    for name, source in library[0].items():
+        sources.setdefault(name, source)
+    for name, frame in library[1].items():
+        frames.setdefault(name, frame)
+
+    flash = sum(size for name, size in areas.items()
+                if name not in RAM_AREAS and name not in ABSOLUTE_AREAS)
+    # The initialized variables also keep their initial values in flash, as
+    # the INITIALIZER area, which is already counted
+    ram = sum(areas.get(name, 0) for name in RAM_AREAS)
+
+    # The code, const and data bytes of every function or variable
+    rows = {}
+    for area, name, size in symbols:
+        row = rows.setdefault(name, {'code': 0, 'const': 0, 'data': 0})
+        if area in RAM_AREAS:
+            row['data'] += size
+        elif area in CONST_AREAS:
+            row['const'] += size
+        else:
+            row['code'] += size
+
+    print('{}: flash {} / {} bytes, ram {} / {} bytes'.format(
+        program, flash, device[0], ram, device[1]))
+    if verbose:
+        print('  {:>6} {:>6} {:>6} {:>6}  {:<32} {}'.format(
+            'code', 'const', 'data', 'frame', 'symbol', 'source'))
+        for name, row in sorted(rows.items(), key=lambda item: -sum(item[1].values())):
+            print('  {:>6} {:>6} {:>6} {:>6}  {:<32} {}'.format(
+                row['code'], row['const'], row['data'], frames.get(name, ''),
+                name[1:], sources.get(name) or ''))
+
+        # The code per source file of the program and per header of the
+        # library
+        totals = {}
+        for name, row in rows.items():
+            source = sourceGroup(sources.get(name) or '(unknown)')
+            totals[source] = totals.get(source, 0) + row['code']
+        for source, code in sorted(totals.items(), key=lambda item: -item[1]):
+            if code == 0:
+                continue
+            print('  {:>6} code bytes in {}'.format(code, source))
+
+    measured.append((program, 'flash', flash))
+    for name, row in sorted(rows.items()):
+        if row['code'] > 0:
+            measured.append((program, name[1:], row['code']))
+
+    violations = 0
+    limits = [('flash', device[0]), ('ram', device[1])]
+    limits += [(item, limit) for name, item, limit in budget if name in ('*', program)]
+    for item, limit in limits:
+        if item == 'flash':
+            value = flash
+        elif item == 'ram':
+            value = ram
+        elif '_' + item in rows:
+            value = rows['_' + item]['code']
+        else:
+            continue
+        if value > limit:
+            print('  OVER BUDGET: {} is {} bytes, the limit is {}'.format(item, value, limit))
+            violations += 1
+    return violations
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Reports the footprint of SDCC programs')
+    parser.add_argument('--model', default='STM8S103F2', choices=sorted(DEVICES))
+    parser.add_argument('--budget', help='The budget file')
+    parser.add_argument('--library', help='The build directory of the library modules')
+    parser.add_argument('--verbose', action='store_true', help='Show every symbol and source file')
+    parser.add_argument('--write-budget', type=int, metavar='MARGIN',
+                        help='Write the measured limits to the budget file, with MARGIN percent headroom')
+    parser.add_argument('maps', nargs='+', metavar='MAP_FILE')
+    args = parser.parse_args()
+
+    budget = readBudget(args.budget)
+    library = parseLibrary(args.library)
+    violations = 0
+    measured = []
+    for path in args.maps:
+        violations += report(path, DEVICES[args.model], budget, library, args.verbose, measured)
+    if args.write_budget is not None:
+        if args.budget is None:
+            sys.exit('--write-budget needs the --budget file')
+        writeBudget(args.budget, measured, args.write_budget)
+        return
+    if violations:
+        sys.exit('{} footprint limits exceeded'.format(violations))
+
+
+if __name__ == '__main__':
+    main()